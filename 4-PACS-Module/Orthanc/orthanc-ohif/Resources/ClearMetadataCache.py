@@ -39,7 +39,12 @@ args = parser.parse_args()
 auth = requests.auth.HTTPBasicAuth(args.username, args.password)
 
 METADATA = '4202'
+METADATA_VOI = '4203'
 
 for instance in requests.get('%s/instances' % args.url, auth=auth).json():
     if METADATA in requests.get('%s/instances/%s/metadata' % (args.url, instance), auth=auth).json():
         requests.delete('%s/instances/%s/metadata/%s' % (args.url, instance, METADATA), auth=auth)
+
+for series in requests.get('%s/series' % args.url, auth=auth).json():
+    if METADATA_VOI in requests.get('%s/series/%s/metadata' % (args.url, series), auth=auth).json():
+        requests.delete('%s/series/%s/metadata/%s' % (args.url, series, METADATA_VOI), auth=auth)
@@ -35,15 +35,35 @@
 
 #include <EmbeddedResources.h>
 
+#include <boost/lexical_cast.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 #define ORTHANC_PLUGIN_NAME  "ohif"
 
 
 static const std::string  METADATA_OHIF = "4202";
+static const std::string  METADATA_OHIF_VOI = "4203";
 static const char* const  KEY_VERSION = "Version";
 static const unsigned int MAX_INSTANCES_IN_QUEUE = 10000;
+static const unsigned int MAX_SERIES_IN_QUEUE = 1000;
+static const unsigned int PRELOAD_PERIOD_MS = 1000;
+static const unsigned int PRELOAD_MIN_PAUSE_MS = 10;
+static const unsigned int PRELOAD_MAX_PAUSE_MS = 2000;
+static const int          VOI_VERSION = 1;
+static const unsigned int VOI_SAMPLED_SLICES = 8;
+static const unsigned int VOI_PERCENTILE_BINS = 4096;
+static const unsigned int VOI_HISTOGRAM_BINS = 256;
+static const double       VOI_LOWER_PERCENTILE = 0.01;
+static const double       VOI_UPPER_PERCENTILE = 0.99;
+static const unsigned int MAX_PENDING_STUDY_CHANGES = 1000;
+static const unsigned int STUDY_EVENTS_COALESCING_MS = 1000;
+static const unsigned int STUDY_EVENTS_RETRY_MS = 1000;
 
 
 enum DataSource
@@ -106,6 +126,31 @@ typedef std::map<Orthanc::DicomTag, TagInformation>  TagsDictionary;
 static TagsDictionary ohifStudyTags_, ohifSeriesTags_, ohifInstanceTags_, allTags_;
 
 
+/**
+ * The same dictionaries as pairs (key in the JSON of the instances,
+ * name in OHIF). The keys are formatted once at startup, instead of
+ * twice per tag and per instance in each "GenerateOhifStudy()".
+ **/
+typedef std::vector< std::pair<std::string, std::string> >  FormattedTags;
+
+static FormattedTags ohifStudyKeys_, ohifSeriesKeys_, ohifInstanceKeys_;
+
+// Keys of the tags that identify an instance, also formatted once
+static std::string keyPatientId_, keyStudyInstanceUid_, keySeriesInstanceUid_, keySopInstanceUid_, keyModality_;
+
+static void FormatTags(FormattedTags& target,
+                       const TagsDictionary& source)
+{
+  target.clear();
+  target.reserve(source.size());
+
+  for (TagsDictionary::const_iterator it = source.begin(); it != source.end(); ++it)
+  {
+    target.push_back(std::make_pair(it->first.Format(), it->second.GetName()));
+  }
+}
+
+
 static const Orthanc::DicomTag RADIOPHARMACEUTICAL_INFORMATION_SEQUENCE(0x0054, 0x0016);
 
 static void InitializeOhifTags()
@@ -210,6 +255,16 @@ static void InitializeOhifTags()
            allTags_[it->first] == it->second);
     allTags_[it->first] = it->second;
   }
+
+  FormatTags(ohifStudyKeys_, ohifStudyTags_);
+  FormatTags(ohifSeriesKeys_, ohifSeriesTags_);
+  FormatTags(ohifInstanceKeys_, ohifInstanceTags_);
+
+  keyPatientId_ = Orthanc::DICOM_TAG_PATIENT_ID.Format();
+  keyStudyInstanceUid_ = Orthanc::DICOM_TAG_STUDY_INSTANCE_UID.Format();
+  keySeriesInstanceUid_ = Orthanc::DICOM_TAG_SERIES_INSTANCE_UID.Format();
+  keySopInstanceUid_ = Orthanc::DICOM_TAG_SOP_INSTANCE_UID.Format();
+  keyModality_ = Orthanc::DICOM_TAG_MODALITY.Format();
 }
 
 
@@ -281,6 +336,338 @@ public:
 };
 
 
+/**
+ * Bounded broadcast buffer of the study-level change notifications
+ * that are published to the OHIF study list. Each event is formatted
+ * once as a "text/event-stream" record, so fanning it out to many
+ * clients only copies strings. A client whose cursor is older than
+ * the oldest buffered event receives a "resync" event, meaning that
+ * it must reload its study list.
+ **/
+class StudyEventsBroadcaster : public boost::noncopyable
+{
+private:
+  struct Event
+  {
+    uint64_t     sequence_;
+    std::string  formatted_;
+  };
+
+  boost::mutex               mutex_;
+  boost::condition_variable  changed_;
+  std::deque<Event>          events_;
+  size_t                     capacity_;
+  uint64_t                   lastSequence_;
+  unsigned int               countWaiters_;
+  bool                       stopped_;
+
+  static void FormatEvent(std::string& target,
+                          uint64_t sequence,
+                          const std::string& type,
+                          const std::string& data)
+  {
+    target = ("id: " + boost::lexical_cast<std::string>(sequence) + "\n" +
+              "event: " + type + "\n" +
+              "data: " + data + "\n\n");
+  }
+
+public:
+  StudyEventsBroadcaster() :
+    capacity_(1000),
+    lastSequence_(0),
+    countWaiters_(0),
+    stopped_(false)
+  {
+  }
+
+  void SetCapacity(size_t capacity)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    capacity_ = std::max<size_t>(1, capacity);
+
+    while (events_.size() > capacity_)
+    {
+      events_.pop_front();
+    }
+  }
+
+  uint64_t GetLastSequence()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return lastSequence_;
+  }
+
+  void Publish(const std::string& type,
+               const Json::Value& payload)
+  {
+    std::string data;
+    Orthanc::Toolbox::WriteFastJson(data, payload);
+
+    // A newline inside "data" would split the event
+    while (!data.empty() &&
+           data[data.size() - 1] == '\n')
+    {
+      data.resize(data.size() - 1);
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+
+    Event event;
+    event.sequence_ = ++lastSequence_;
+    FormatEvent(event.formatted_, event.sequence_, type, data);
+    events_.push_back(event);
+
+    if (events_.size() > capacity_)
+    {
+      events_.pop_front();
+    }
+
+    changed_.notify_all();
+  }
+
+  /**
+   * Wakes up the clients that are waiting for events, and makes
+   * further calls to "Collect()" return immediately.
+   **/
+  void Stop()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stopped_ = true;
+    changed_.notify_all();
+  }
+
+  /**
+   * Appends to "target" the events that are more recent than
+   * "since". If there is none yet, waits for at most "timeout"
+   * milliseconds, unless "maxWaiters" clients are already waiting
+   * (waiting ties up one HTTP thread of Orthanc), in which case
+   * "overloaded" is set. Returns "false" if no event was appended.
+   * "cursor" receives the sequence of the last event, to be sent back
+   * as "since" by the next call.
+   **/
+  bool Collect(std::string& target,
+               uint64_t& cursor,
+               bool& overloaded,
+               uint64_t since,
+               unsigned int timeout,
+               unsigned int maxWaiters)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    overloaded = false;
+
+    if (since > lastSequence_ ||  // Cursor from a previous execution of Orthanc
+        (!events_.empty() && since + 1 < events_.front().sequence_))  // The client fell behind
+    {
+      std::string resync;
+      FormatEvent(resync, lastSequence_, "resync", "{}");
+      target += resync;
+      cursor = lastSequence_;
+      return true;
+    }
+
+    if (since == lastSequence_ &&
+        timeout > 0 &&
+        !stopped_ &&
+        countWaiters_ >= maxWaiters)
+    {
+      overloaded = true;
+    }
+    else if (since == lastSequence_ &&
+             timeout > 0 &&
+             !stopped_)
+    {
+      const boost::system_time deadline = (boost::get_system_time() +
+                                           boost::posix_time::milliseconds(timeout));
+
+      countWaiters_++;
+      while (since == lastSequence_ &&
+             !stopped_ &&
+             changed_.timed_wait(lock, deadline))
+      {
+      }
+      countWaiters_--;
+    }
+
+    cursor = lastSequence_;
+
+    if (since == lastSequence_)
+    {
+      return false;
+    }
+    else if (since + 1 < events_.front().sequence_)
+    {
+      // The buffer wrapped around while waiting (burst of events)
+      std::string resync;
+      FormatEvent(resync, lastSequence_, "resync", "{}");
+      target += resync;
+      return true;
+    }
+    else
+    {
+      for (size_t i = static_cast<size_t>(since + 1 - events_.front().sequence_); i < events_.size(); i++)
+      {
+        target += events_[i].formatted_;
+      }
+
+      return true;
+    }
+  }
+};
+
+
+/**
+ * Adaptive control of the preload threads, with the additive
+ * increase and multiplicative decrease of TCP congestion control.
+ * Before each item, a preload thread times one metadata lookup: this
+ * probe costs the same whatever the size of the instance or of the
+ * series, so its latency only reflects how busy the REST API and the
+ * index of Orthanc are, as foreground requests see them. Once per
+ * period, if the mean latency exceeds the target, the number of
+ * active threads is halved, then a growing pause is inserted between
+ * two instances once only one thread is left. Below the target, the
+ * pause is removed first, then one more thread is activated per
+ * period, as long as more instances are pending than threads are
+ * active.
+ **/
+class PreloadThrottle : public boost::noncopyable
+{
+private:
+  boost::mutex              mutex_;
+  unsigned int              targetLatency_;   // In milliseconds
+  unsigned int              maxConcurrency_;
+  unsigned int              concurrency_;
+  unsigned int              pause_;           // In milliseconds
+  uint64_t                  sumLatencies_;    // In microseconds, over the current period
+  unsigned int              countSamples_;
+  unsigned int              countProcessed_;
+  boost::posix_time::ptime  periodStart_;
+
+  static void SetMetricsValue(const char* name,
+                              float value)
+  {
+#if HAS_ORTHANC_PLUGIN_METRICS == 1
+    OrthancPluginSetMetricsValue(OrthancPlugins::GetGlobalContext(), name, value, OrthancPluginMetricsType_Default);
+#endif
+  }
+
+  void Adjust(size_t queueSize)
+  {
+    const double latency = static_cast<double>(sumLatencies_) / static_cast<double>(countSamples_) / 1000.0;
+
+    if (latency > static_cast<double>(targetLatency_))
+    {
+      if (concurrency_ > 1)
+      {
+        concurrency_ /= 2;
+      }
+      else
+      {
+        pause_ = std::min(PRELOAD_MAX_PAUSE_MS, std::max(PRELOAD_MIN_PAUSE_MS, 2 * pause_));
+      }
+    }
+    else if (pause_ > 0)
+    {
+      pause_ = (pause_ / 2 < PRELOAD_MIN_PAUSE_MS ? 0 : pause_ / 2);
+    }
+    else if (concurrency_ < maxConcurrency_ &&
+             queueSize > concurrency_)
+    {
+      concurrency_++;
+    }
+
+    SetMetricsValue("ohif_preload_latency_ms", static_cast<float>(latency));
+  }
+
+public:
+  PreloadThrottle() :
+    targetLatency_(100),
+    maxConcurrency_(1),
+    concurrency_(1),
+    pause_(0),
+    sumLatencies_(0),
+    countSamples_(0),
+    countProcessed_(0),
+    periodStart_(boost::posix_time::microsec_clock::universal_time())
+  {
+  }
+
+  void Configure(unsigned int targetLatency,
+                 unsigned int maxConcurrency)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    targetLatency_ = targetLatency;
+    maxConcurrency_ = std::max(1u, maxConcurrency);
+    concurrency_ = 1;  // Start slowly
+  }
+
+  unsigned int GetMaxConcurrency()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return maxConcurrency_;
+  }
+
+  // Threads whose index is above the current concurrency stay idle
+  bool IsActive(unsigned int thread)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return thread < concurrency_;
+  }
+
+  unsigned int GetPause()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return pause_;
+  }
+
+  // Latency of one probe, see the class documentation
+  void AddSample(const boost::posix_time::time_duration& latency)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    sumLatencies_ += static_cast<uint64_t>(latency.total_microseconds());
+    countSamples_++;
+  }
+
+  void AddProcessed()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    countProcessed_++;
+  }
+
+  /**
+   * To be called regularly by the preload threads, even if idle. At
+   * the end of each period, adjusts the concurrency and publishes the
+   * metrics.
+   **/
+  void Update(size_t queueSize)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    const boost::posix_time::time_duration elapsed = now - periodStart_;
+
+    if (elapsed.total_milliseconds() >= static_cast<int64_t>(PRELOAD_PERIOD_MS))
+    {
+      if (countSamples_ > 0)
+      {
+        Adjust(queueSize);
+      }
+
+      SetMetricsValue("ohif_preload_concurrency", static_cast<float>(concurrency_));
+      SetMetricsValue("ohif_preload_pause_ms", static_cast<float>(pause_));
+      SetMetricsValue("ohif_preload_queue_size", static_cast<float>(queueSize));
+      SetMetricsValue("ohif_preload_rate", static_cast<float>(countProcessed_) * 1000.0f /
+                      static_cast<float>(elapsed.total_milliseconds()));
+
+      sumLatencies_ = 0;
+      countSamples_ = 0;
+      countProcessed_ = 0;
+      periodStart_ = now;
+    }
+  }
+};
+
+
 static bool ParseTagFromOrthanc(Json::Value& target,
                                 const Orthanc::DicomTag& tag,
                                 const std::string& name,
@@ -464,11 +851,11 @@ static std::string GetCacheUri(const std::string& instanceId)
 }
 
 
-static void CacheAsMetadata(const Json::Value& instanceTags,
-                            const std::string& instanceId)
+static void WriteCompressedMetadata(const std::string& uri,
+                                   const Json::Value& value)
 {
   std::string uncompressed;
-  Orthanc::Toolbox::WriteFastJson(uncompressed, instanceTags);
+  Orthanc::Toolbox::WriteFastJson(uncompressed, value);
 
   std::string compressed;
   Orthanc::GzipCompressor compressor;
@@ -478,19 +865,19 @@ static void CacheAsMetadata(const Json::Value& instanceTags,
   Orthanc::Toolbox::EncodeBase64(metadata, compressed);
 
   Json::Value answer;
-  OrthancPlugins::RestApiPut(answer, GetCacheUri(instanceId), metadata.c_str(), metadata.size(), false);
+  OrthancPlugins::RestApiPut(answer, uri, metadata.c_str(), metadata.size(), false);
 }
 
 
-static bool GetOhifInstance(Json::Value& target,
-                            const std::string& instanceId)
+/**
+ * Reads a metadata written by "WriteCompressedMetadata()". Returns
+ * "false" if it is absent, and removes it if it is corrupted or was
+ * written with another version than "version".
+ **/
+static bool ReadCompressedMetadata(Json::Value& target,
+                                   const std::string& uri,
+                                   int version)
 {
-#if 0
-  // This disables all the caching (for debugging)
-  return EncodeOhifInstance(target, instanceId);
-#else
-  const std::string uri = GetCacheUri(instanceId);
-  
   std::string metadata;
   
   if (OrthancPlugins::RestApiGetString(metadata, uri, false))
@@ -507,7 +894,7 @@ static bool GetOhifInstance(Json::Value& target,
       if (Orthanc::Toolbox::ReadJson(target, uncompressed) &&
           target.isMember(KEY_VERSION) &&
           target[KEY_VERSION].type() == Json::intValue &&
-          target[KEY_VERSION].asInt() == METADATA_VERSION)
+          target[KEY_VERSION].asInt() == version)
       {
         // Success, we can reuse the cached value
         return true;
@@ -521,6 +908,29 @@ static bool GetOhifInstance(Json::Value& target,
     OrthancPlugins::RestApiDelete(uri, false);
   }
 
+  return false;
+}
+
+
+static void CacheAsMetadata(const Json::Value& instanceTags,
+                            const std::string& instanceId)
+{
+  WriteCompressedMetadata(GetCacheUri(instanceId), instanceTags);
+}
+
+
+static bool GetOhifInstance(Json::Value& target,
+                            const std::string& instanceId)
+{
+#if 0
+  // This disables all the caching (for debugging)
+  return EncodeOhifInstance(target, instanceId);
+#else
+  if (ReadCompressedMetadata(target, GetCacheUri(instanceId), METADATA_VERSION))
+  {
+    return true;
+  }
+
   if (EncodeOhifInstance(target, instanceId))
   {
     CacheAsMetadata(target, instanceId);
@@ -534,102 +944,609 @@ static bool GetOhifInstance(Json::Value& target,
 }
 
 
-static ResourcesCache               cache_;
-static std::string                  userConfiguration_;
-static std::string                  routerBasename_;
-static DataSource                   dataSource_;
-static bool                         preload_;
-static boost::thread                metadataThread_;
-static Orthanc::SharedMessageQueue  pendingInstances_;
-static bool                         continueThread_;
-
-void ServeFile(OrthancPluginRestOutput* output,
-               const char* url,
-               const OrthancPluginHttpRequest* request)
+static std::string GetVoiCacheUri(const std::string& seriesId)
 {
-  OrthancPluginContext* context = OrthancPlugins::GetGlobalContext();
-  
-  // The next 3 HTTP headers are required to enable SharedArrayBuffer
-  // (https://web.dev/coop-coep/)
-  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Embedder-Policy", "require-corp");
-  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Opener-Policy", "same-origin");
-  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Resource-Policy", "same-origin");
+  return "/series/" + seriesId + "/metadata/" + METADATA_OHIF_VOI;
+}
 
-  std::string uri;
-  if (request->groupsCount > 0)
-  {
-    uri = request->groups[0];
-  }
 
-  if (uri == "app-config.js")
+/**
+ * Range of the pixel values in one row of a 16-bit image. The pixels
+ * are XOR-ed with "flip" to compare them as signed integers, which
+ * turns unsigned images (flip = 0x8000) into signed ones, as SSE2
+ * only has signed 16-bit min/max. The SSE2 reductions process 8
+ * pixels per instruction.
+ **/
+static void GetRowRange16(int16_t& minValue,
+                          int16_t& maxValue,
+                          const uint16_t* row,
+                          size_t width,
+                          uint16_t flip)
+{
+  size_t x = 0;
+
+#if defined(__SSE2__)
+  if (width >= 8)
   {
-    std::string system;
-    Orthanc::EmbeddedResources::GetFileResource(system, Orthanc::EmbeddedResources::APP_CONFIG_SYSTEM);
+    const __m128i mask = _mm_set1_epi16(static_cast<int16_t>(flip));
+    __m128i low = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row)), mask);
+    __m128i high = low;
 
-    std::map<std::string, std::string> dictionary;
-    dictionary["ROUTER_BASENAME"] = routerBasename_;
-    dictionary["USE_DICOM_WEB"] = (dataSource_ == DataSource_DicomWeb ? "true" : "false");
+    for (x = 8; x + 8 <= width; x += 8)
+    {
+      const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), mask);
+      low = _mm_min_epi16(low, v);
+      high = _mm_max_epi16(high, v);
+    }
 
-    system = Orthanc::Toolbox::SubstituteVariables(system, dictionary);
+    int16_t lanesLow[8], lanesHigh[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesLow), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesHigh), high);
 
-    std::string s = (userConfiguration_ + "\n" + system);
-    OrthancPluginAnswerBuffer(context, output, s.c_str(), s.size(), "text/javascript");
-  }
-  else if (uri == "" ||             // Study list
-           uri == "tmtv" ||         // Total metabolic tumor volume
-           uri == "viewer" ||       // Default viewer (including MPR)
-           uri == "segmentation" || // Segmentation mode
-           uri == "microscopy"      // Microscopy mode
-           )  
-  {
-    // Those correspond to the different modes of the OHIF platform:
-    // https://v3-docs.ohif.org/platform/modes/
-    cache_.Answer(context, output, "index.html");
+    for (unsigned int i = 0; i < 8; i++)
+    {
+      minValue = std::min(minValue, lanesLow[i]);
+      maxValue = std::max(maxValue, lanesHigh[i]);
+    }
   }
-  else 
+#endif
+
+  for (; x < width; x++)
   {
-    cache_.Answer(context, output, uri);
+    const int16_t v = static_cast<int16_t>(row[x] ^ flip);
+    minValue = std::min(minValue, v);
+    maxValue = std::max(maxValue, v);
   }
 }
 
 
-static void GenerateOhifStudy(Json::Value& target,
-                              const std::string& studyId)
+static void GetRowRange8(uint8_t& minValue,
+                         uint8_t& maxValue,
+                         const uint8_t* row,
+                         size_t width)
 {
-  // https://v3-docs.ohif.org/configuration/dataSources/dicom-json
-  static const char* const KEY_ID = "ID";
-  const std::string KEY_PATIENT_ID = Orthanc::DICOM_TAG_PATIENT_ID.Format();
-  const std::string KEY_STUDY_INSTANCE_UID = Orthanc::DICOM_TAG_STUDY_INSTANCE_UID.Format();
-  const std::string KEY_SERIES_INSTANCE_UID = Orthanc::DICOM_TAG_SERIES_INSTANCE_UID.Format();
-  const std::string KEY_SOP_INSTANCE_UID = Orthanc::DICOM_TAG_SOP_INSTANCE_UID.Format();
-  
-  Json::Value instancesIds;
-  if (!OrthancPlugins::RestApiGet(instancesIds, "/studies/" + studyId + "/instances", false))
-  {
-    throw Orthanc::OrthancException(Orthanc::ErrorCode_UnknownResource);
-  }
+  size_t x = 0;
 
-  if (instancesIds.type() != Json::arrayValue)
+#if defined(__SSE2__)
+  if (width >= 16)
   {
-    throw Orthanc::OrthancException(Orthanc::ErrorCode_InternalError);
-  }
-
-  std::vector<Json::Value> instancesTags;
-  instancesTags.reserve(instancesIds.size());
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+    __m128i high = low;
 
-  for (Json::ArrayIndex i = 0; i < instancesIds.size(); i++)
-  {
-    if (instancesIds[i].type() != Json::objectValue ||
-        !instancesIds[i].isMember(KEY_ID) ||
-        instancesIds[i][KEY_ID].type() != Json::stringValue)
+    for (x = 16; x + 16 <= width; x += 16)
     {
-      throw Orthanc::OrthancException(Orthanc::ErrorCode_InternalError);
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+      low = _mm_min_epu8(low, v);
+      high = _mm_max_epu8(high, v);
     }
 
-    Json::Value t;
-    if (GetOhifInstance(t, instancesIds[i][KEY_ID].asString()))
+    uint8_t lanesLow[16], lanesHigh[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesLow), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesHigh), high);
+
+    for (unsigned int i = 0; i < 16; i++)
     {
-      instancesTags.push_back(t);
+      minValue = std::min(minValue, lanesLow[i]);
+      maxValue = std::max(maxValue, lanesHigh[i]);
+    }
+  }
+#endif
+
+  for (; x < width; x++)
+  {
+    minValue = std::min(minValue, row[x]);
+    maxValue = std::max(maxValue, row[x]);
+  }
+}
+
+
+// Exact histogram of the stored pixel values of one slice
+struct SliceHistogram
+{
+  double                 slope_;
+  double                 intercept_;
+  int32_t                minimum_;  // Stored value counted by "counts_[0]"
+  std::vector<uint32_t>  counts_;
+};
+
+
+template <typename Pixel>
+static void CountPixels(SliceHistogram& target,
+                        const OrthancPlugins::OrthancImage& image)
+{
+  const uint8_t* buffer = reinterpret_cast<const uint8_t*>(image.GetBuffer());
+
+  for (unsigned int y = 0; y < image.GetHeight(); y++)
+  {
+    const Pixel* row = reinterpret_cast<const Pixel*>(buffer + y * image.GetPitch());
+    for (unsigned int x = 0; x < image.GetWidth(); x++)
+    {
+      target.counts_[static_cast<int32_t>(row[x]) - target.minimum_]++;
+    }
+  }
+}
+
+
+static bool ComputeSliceHistogram(SliceHistogram& target,
+                                  const OrthancPlugins::OrthancImage& image)
+{
+  const uint8_t* buffer = reinterpret_cast<const uint8_t*>(image.GetBuffer());
+
+  if (image.GetWidth() == 0 ||
+      image.GetHeight() == 0)
+  {
+    return false;
+  }
+
+  // First pass: range of the stored values, to size the counters
+  int32_t minimum, maximum;
+
+  switch (image.GetPixelFormat())
+  {
+    case OrthancPluginPixelFormat_Grayscale8:
+    {
+      uint8_t low = std::numeric_limits<uint8_t>::max();
+      uint8_t high = std::numeric_limits<uint8_t>::min();
+      for (unsigned int y = 0; y < image.GetHeight(); y++)
+      {
+        GetRowRange8(low, high, buffer + y * image.GetPitch(), image.GetWidth());
+      }
+      minimum = low;
+      maximum = high;
+      break;
+    }
+
+    case OrthancPluginPixelFormat_Grayscale16:
+    case OrthancPluginPixelFormat_SignedGrayscale16:
+    {
+      const uint16_t flip = (image.GetPixelFormat() == OrthancPluginPixelFormat_Grayscale16 ? 0x8000 : 0);
+      int16_t low = std::numeric_limits<int16_t>::max();
+      int16_t high = std::numeric_limits<int16_t>::min();
+      for (unsigned int y = 0; y < image.GetHeight(); y++)
+      {
+        GetRowRange16(low, high, reinterpret_cast<const uint16_t*>(buffer + y * image.GetPitch()), image.GetWidth(), flip);
+      }
+      minimum = static_cast<int32_t>(flip == 0 ? low : static_cast<uint16_t>(low ^ flip));
+      maximum = static_cast<int32_t>(flip == 0 ? high : static_cast<uint16_t>(high ^ flip));
+      break;
+    }
+
+    default:
+      // Color images have no VOI
+      return false;
+  }
+
+  // Second pass: one counter per stored value
+  target.minimum_ = minimum;
+  target.counts_.assign(static_cast<size_t>(maximum - minimum + 1), 0);
+
+  switch (image.GetPixelFormat())
+  {
+    case OrthancPluginPixelFormat_Grayscale8:
+      CountPixels<uint8_t>(target, image);
+      break;
+
+    case OrthancPluginPixelFormat_Grayscale16:
+      CountPixels<uint16_t>(target, image);
+      break;
+
+    case OrthancPluginPixelFormat_SignedGrayscale16:
+      CountPixels<int16_t>(target, image);
+      break;
+
+    default:
+      throw Orthanc::OrthancException(Orthanc::ErrorCode_InternalError);
+  }
+
+  return true;
+}
+
+
+static double GetTagAsDouble(const Json::Value& instanceTags,
+                             const Orthanc::DicomTag& tag,
+                             double defaultValue)
+{
+  const std::string key = tag.Format();
+  if (instanceTags.isMember(key) &&
+      instanceTags[key].isNumeric())
+  {
+    return instanceTags[key].asDouble();
+  }
+  else
+  {
+    return defaultValue;
+  }
+}
+
+
+// VOI of a series that has none, until its number of instances changes
+static void SetNoSeriesVoi(Json::Value& target,
+                           Json::ArrayIndex countInstances)
+{
+  target = Json::objectValue;
+  target[KEY_VERSION] = VOI_VERSION;
+  target["NumInstances"] = countInstances;
+}
+
+
+/**
+ * Computes the intensity histogram of a series over a sample of its
+ * slices, in modality units (i.e. after the rescale slope and
+ * intercept), and its default VOI from the VOI_LOWER_PERCENTILE and
+ * VOI_UPPER_PERCENTILE percentiles. Returns "false" if the series
+ * cannot be read. Color series, and series without a decodable
+ * slice, get a VOI without "WindowCenter" (cf. "SetNoSeriesVoi()"),
+ * so that their slices are not downloaded again at each request.
+ **/
+static bool ComputeSeriesVoi(Json::Value& target,
+                             const std::string& seriesId)
+{
+  Json::Value series;
+  if (!OrthancPlugins::RestApiGet(series, "/series/" + seriesId, false) ||
+      series.type() != Json::objectValue ||
+      !series.isMember("Instances") ||
+      series["Instances"].type() != Json::arrayValue ||
+      series["Instances"].size() == 0)
+  {
+    return false;
+  }
+
+  const Json::Value& instances = series["Instances"];
+  const Json::ArrayIndex countSampled = std::min<Json::ArrayIndex>(instances.size(), VOI_SAMPLED_SLICES);
+
+  std::list<SliceHistogram> slices;
+
+  for (Json::ArrayIndex i = 0; i < countSampled; i++)
+  {
+    // Slices evenly spread over the series
+    const std::string instanceId = instances[(2 * i + 1) * instances.size() / (2 * countSampled)].asString();
+
+    Json::Value tags;
+    if (!GetOhifInstance(tags, instanceId))
+    {
+      continue;
+    }
+
+    const std::string photometric = Orthanc::DICOM_TAG_PHOTOMETRIC_INTERPRETATION.Format();
+    if (tags.isMember(photometric) &&
+        tags[photometric].type() == Json::stringValue &&
+        tags[photometric].asString().compare(0, 10, "MONOCHROME") != 0)
+    {
+      SetNoSeriesVoi(target, instances.size());
+      return true;
+    }
+
+    OrthancPlugins::MemoryBuffer dicom;
+    if (!dicom.RestApiGet("/instances/" + instanceId + "/file", false))
+    {
+      continue;
+    }
+
+    try
+    {
+      OrthancPlugins::OrthancImage image;
+      image.DecodeDicomImage(dicom.GetData(), dicom.GetSize(), 0);
+
+      slices.push_back(SliceHistogram());
+      slices.back().slope_ = GetTagAsDouble(tags, Orthanc::DICOM_TAG_RESCALE_SLOPE, 1);
+      slices.back().intercept_ = GetTagAsDouble(tags, Orthanc::DICOM_TAG_RESCALE_INTERCEPT, 0);
+
+      if (!ComputeSliceHistogram(slices.back(), image))
+      {
+        SetNoSeriesVoi(target, instances.size());
+        return true;
+      }
+    }
+    catch (Orthanc::OrthancException&)
+    {
+      // Unsupported transfer syntax, skip this slice
+    }
+  }
+
+  if (slices.empty())
+  {
+    SetNoSeriesVoi(target, instances.size());
+    return true;
+  }
+
+  // Range of the series in modality units
+  double minimum = std::numeric_limits<double>::max();
+  double maximum = -std::numeric_limits<double>::max();
+
+  for (std::list<SliceHistogram>::const_iterator it = slices.begin(); it != slices.end(); ++it)
+  {
+    const double a = it->slope_ * static_cast<double>(it->minimum_) + it->intercept_;
+    const double b = it->slope_ * (static_cast<double>(it->minimum_) + static_cast<double>(it->counts_.size() - 1)) + it->intercept_;
+    minimum = std::min(minimum, std::min(a, b));
+    maximum = std::max(maximum, std::max(a, b));
+  }
+
+  // Each distinct stored value of a slice is rescaled once, not each pixel
+  std::vector<uint64_t> bins(VOI_PERCENTILE_BINS, 0);
+  uint64_t total = 0;
+  const double scale = (maximum > minimum ? static_cast<double>(VOI_PERCENTILE_BINS) / (maximum - minimum) : 0);
+
+  for (std::list<SliceHistogram>::const_iterator it = slices.begin(); it != slices.end(); ++it)
+  {
+    for (size_t i = 0; i < it->counts_.size(); i++)
+    {
+      if (it->counts_[i] > 0)
+      {
+        const double value = it->slope_ * static_cast<double>(it->minimum_ + static_cast<int32_t>(i)) + it->intercept_;
+        const size_t bin = std::min<size_t>(VOI_PERCENTILE_BINS - 1, static_cast<size_t>((value - minimum) * scale));
+        bins[bin] += it->counts_[i];
+        total += it->counts_[i];
+      }
+    }
+  }
+
+  const uint64_t lowerRank = static_cast<uint64_t>(VOI_LOWER_PERCENTILE * static_cast<double>(total));
+  const uint64_t upperRank = static_cast<uint64_t>(VOI_UPPER_PERCENTILE * static_cast<double>(total));
+
+  size_t lowerBin = 0, upperBin = VOI_PERCENTILE_BINS - 1;
+  uint64_t cumulated = 0;
+  bool hasLower = false;
+
+  for (size_t i = 0; i < VOI_PERCENTILE_BINS; i++)
+  {
+    cumulated += bins[i];
+
+    if (!hasLower &&
+        cumulated > lowerRank)
+    {
+      lowerBin = i;
+      hasLower = true;
+    }
+
+    if (cumulated > upperRank)
+    {
+      upperBin = i;
+      break;
+    }
+  }
+
+  double lower, upper;
+  if (scale > 0)
+  {
+    lower = minimum + static_cast<double>(lowerBin) / scale;
+    upper = minimum + static_cast<double>(upperBin + 1) / scale;
+  }
+  else
+  {
+    // Uniform series
+    lower = minimum;
+    upper = minimum;
+  }
+
+  target = Json::objectValue;
+  target[KEY_VERSION] = VOI_VERSION;
+  target["NumInstances"] = instances.size();
+  target["SampledSlices"] = static_cast<unsigned int>(slices.size());
+  target["WindowCenter"] = (lower + upper) / 2.0;
+  target["WindowWidth"] = std::max(1.0, upper - lower);
+  target["Minimum"] = minimum;
+  target["Maximum"] = maximum;
+
+  // Coarser histogram for the clients
+  static const size_t MERGED_BINS = VOI_PERCENTILE_BINS / VOI_HISTOGRAM_BINS;
+
+  target["Histogram"] = Json::arrayValue;
+  for (size_t i = 0; i < VOI_HISTOGRAM_BINS; i++)
+  {
+    uint64_t count = 0;
+    for (size_t j = 0; j < MERGED_BINS; j++)
+    {
+      count += bins[i * MERGED_BINS + j];
+    }
+
+    target["Histogram"].append(static_cast<Json::UInt64>(count));
+  }
+
+  return true;
+}
+
+
+/**
+ * Computes the VOI of a series, unless the cached one was computed
+ * over the same number of instances. "cached" is the VOI previously
+ * read by the caller, which is only valid if "hasCached" is true.
+ **/
+static void UpdateSeriesVoi(const std::string& seriesId,
+                            bool hasCached,
+                            const Json::Value& cached)
+{
+  Json::Value series;
+  if (hasCached &&
+      OrthancPlugins::RestApiGet(series, "/series/" + seriesId, false) &&
+      series.type() == Json::objectValue &&
+      series.isMember("Instances") &&
+      series["Instances"].type() == Json::arrayValue &&
+      cached.isMember("NumInstances") &&
+      cached["NumInstances"].isNumeric() &&
+      cached["NumInstances"].asUInt() == series["Instances"].size())
+  {
+    return;
+  }
+
+  Json::Value voi;
+  if (ComputeSeriesVoi(voi, seriesId))
+  {
+    WriteCompressedMetadata(GetVoiCacheUri(seriesId), voi);
+  }
+}
+
+
+enum StudyChange
+{
+  StudyChange_New = (1 << 0),
+  StudyChange_Updated = (1 << 1),
+  StudyChange_Stable = (1 << 2),
+  StudyChange_Deleted = (1 << 3)
+};
+
+
+static ResourcesCache               cache_;
+static std::string                  userConfiguration_;
+static std::string                  routerBasename_;
+static DataSource                   dataSource_;
+static bool                         preload_;
+static boost::thread_group          metadataThreads_;
+static PreloadThrottle              preloadThrottle_;
+static Orthanc::SharedMessageQueue  pendingInstances_;
+static bool                         precomputeVoi_;
+static Orthanc::SharedMessageQueue  pendingVoiSeries_;
+static boost::mutex                 queuedVoiSeriesMutex_;
+static std::set<std::string>        queuedVoiSeries_;  // Content of "pendingVoiSeries_"
+static bool                         continueThread_;
+static bool                         studyEvents_;
+static unsigned int                 studyEventsTimeout_;
+static unsigned int                 studyEventsMaxWaiters_;
+static boost::thread                studyEventsThread_;
+static StudyEventsBroadcaster       studyEventsBroadcaster_;
+static boost::mutex                 pendingChangesMutex_;
+static std::map<std::string, unsigned int>  pendingStudies_;  // Orthanc study ID -> StudyChange flags
+static std::set<std::string>        pendingSeries_;
+static bool                         pendingOverflow_;
+
+void ServeFile(OrthancPluginRestOutput* output,
+               const char* url,
+               const OrthancPluginHttpRequest* request)
+{
+  OrthancPluginContext* context = OrthancPlugins::GetGlobalContext();
+  
+  // The next 3 HTTP headers are required to enable SharedArrayBuffer
+  // (https://web.dev/coop-coep/)
+  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Embedder-Policy", "require-corp");
+  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Opener-Policy", "same-origin");
+  OrthancPluginSetHttpHeader(context, output, "Cross-Origin-Resource-Policy", "same-origin");
+
+  std::string uri;
+  if (request->groupsCount > 0)
+  {
+    uri = request->groups[0];
+  }
+
+  if (uri == "app-config.js")
+  {
+    std::string system;
+    Orthanc::EmbeddedResources::GetFileResource(system, Orthanc::EmbeddedResources::APP_CONFIG_SYSTEM);
+
+    std::map<std::string, std::string> dictionary;
+    dictionary["ROUTER_BASENAME"] = routerBasename_;
+    dictionary["USE_DICOM_WEB"] = (dataSource_ == DataSource_DicomWeb ? "true" : "false");
+
+    system = Orthanc::Toolbox::SubstituteVariables(system, dictionary);
+
+    std::string s = (userConfiguration_ + "\n" + system);
+    OrthancPluginAnswerBuffer(context, output, s.c_str(), s.size(), "text/javascript");
+  }
+  else if (uri == "" ||             // Study list
+           uri == "tmtv" ||         // Total metabolic tumor volume
+           uri == "viewer" ||       // Default viewer (including MPR)
+           uri == "segmentation" || // Segmentation mode
+           uri == "microscopy"      // Microscopy mode
+           )  
+  {
+    // Those correspond to the different modes of the OHIF platform:
+    // https://v3-docs.ohif.org/platform/modes/
+    cache_.Answer(context, output, "index.html");
+  }
+  else 
+  {
+    cache_.Answer(context, output, uri);
+  }
+}
+
+
+/**
+ * Queues the computation of the VOI of one series, unless it is
+ * already queued (the same series is typically requested by every
+ * opening of its study until the preload thread catches up).
+ **/
+static void EnqueueSeriesVoi(const std::string& seriesId)
+{
+  if (precomputeVoi_ &&
+      metadataThreads_.size() > 0)
+  {
+    boost::mutex::scoped_lock lock(queuedVoiSeriesMutex_);
+
+    if (queuedVoiSeries_.size() < MAX_SERIES_IN_QUEUE &&
+        queuedVoiSeries_.insert(seriesId).second)
+    {
+      pendingVoiSeries_.Enqueue(new Orthanc::SingleValueObject<std::string>(seriesId));
+    }
+  }
+}
+
+
+static bool GetSeriesVoi(Json::Value& target,
+                         const Json::Value& firstInstanceInSeries)
+{
+  if (!precomputeVoi_)
+  {
+    return false;  // Nothing to look up
+  }
+
+  Orthanc::DicomInstanceHasher hasher(firstInstanceInSeries[keyPatientId_].asString(),
+                                      firstInstanceInSeries[keyStudyInstanceUid_].asString(),
+                                      firstInstanceInSeries[keySeriesInstanceUid_].asString(),
+                                      firstInstanceInSeries[keySopInstanceUid_].asString());
+
+  const std::string seriesId = hasher.HashSeries();
+
+  if (ReadCompressedMetadata(target, GetVoiCacheUri(seriesId), VOI_VERSION))
+  {
+    // No "WindowCenter" if the series has no VOI, until it gets new instances
+    return target.isMember("WindowCenter");
+  }
+  else
+  {
+    // Series that was stored before the VOI was precomputed: not computed here, to keep the request fast
+    EnqueueSeriesVoi(seriesId);
+    return false;
+  }
+}
+
+
+static void GenerateOhifStudy(Json::Value& target,
+                              const std::string& studyId)
+{
+  // https://v3-docs.ohif.org/configuration/dataSources/dicom-json
+  static const char* const KEY_ID = "ID";
+  const std::string& KEY_PATIENT_ID = keyPatientId_;
+  const std::string& KEY_STUDY_INSTANCE_UID = keyStudyInstanceUid_;
+  const std::string& KEY_SERIES_INSTANCE_UID = keySeriesInstanceUid_;
+  const std::string& KEY_SOP_INSTANCE_UID = keySopInstanceUid_;
+  const std::string& KEY_MODALITY = keyModality_;
+  
+  Json::Value instancesIds;
+  if (!OrthancPlugins::RestApiGet(instancesIds, "/studies/" + studyId + "/instances", false))
+  {
+    throw Orthanc::OrthancException(Orthanc::ErrorCode_UnknownResource);
+  }
+
+  if (instancesIds.type() != Json::arrayValue)
+  {
+    throw Orthanc::OrthancException(Orthanc::ErrorCode_InternalError);
+  }
+
+  std::vector<Json::Value> instancesTags;
+  instancesTags.reserve(instancesIds.size());
+
+  for (Json::ArrayIndex i = 0; i < instancesIds.size(); i++)
+  {
+    if (instancesIds[i].type() != Json::objectValue ||
+        !instancesIds[i].isMember(KEY_ID) ||
+        instancesIds[i][KEY_ID].type() != Json::stringValue)
+    {
+      throw Orthanc::OrthancException(Orthanc::ErrorCode_InternalError);
+    }
+
+    // Decoded in place, to avoid copying the JSON of each instance
+    instancesTags.push_back(Json::nullValue);
+    if (!GetOhifInstance(instancesTags.back(), instancesIds[i][KEY_ID].asString()))
+    {
+      instancesTags.pop_back();
     }
   }
 
@@ -637,7 +1554,7 @@ static void GenerateOhifStudy(Json::Value& target,
   typedef std::map<std::string, ListOfResources>  MapOfResources;
 
   MapOfResources studies;
-  for (Json::ArrayIndex i = 0; i < instancesTags.size(); i++)
+  for (size_t i = 0; i < instancesTags.size(); i++)
   {
     if (instancesTags[i].isMember(KEY_STUDY_INSTANCE_UID))
     {
@@ -654,6 +1571,7 @@ static void GenerateOhifStudy(Json::Value& target,
   }
 
   target["studies"] = Json::arrayValue;
+  Json::Value& targetStudies = target["studies"];
   
   for (MapOfResources::const_iterator it = studies.begin(); it != studies.end(); ++it)
   {
@@ -661,13 +1579,14 @@ static void GenerateOhifStudy(Json::Value& target,
     {
       assert(it->second.front() != NULL);
       const Json::Value& firstInstanceInStudy = *it->second.front();
-      
-      Json::Value study = Json::objectValue;
-      for (TagsDictionary::const_iterator tag = ohifStudyTags_.begin(); tag != ohifStudyTags_.end(); ++tag)
+
+      // The answer is built in place, as copying a "Json::Value" copies all its nodes
+      Json::Value& study = targetStudies.append(Json::objectValue);
+      for (FormattedTags::const_iterator tag = ohifStudyKeys_.begin(); tag != ohifStudyKeys_.end(); ++tag)
       {
-        if (firstInstanceInStudy.isMember(tag->first.Format()))
+        if (firstInstanceInStudy.isMember(tag->first))
         {
-          study[tag->second.GetName()] = firstInstanceInStudy[tag->first.Format()];
+          study[tag->second] = firstInstanceInStudy[tag->first];
         }
       }
 
@@ -692,6 +1611,7 @@ static void GenerateOhifStudy(Json::Value& target,
       }
 
       study["series"] = Json::arrayValue;
+      Json::Value& studySeries = study["series"];
 
       std::set<std::string> modalities;
       unsigned int countInstances = 0;
@@ -703,50 +1623,76 @@ static void GenerateOhifStudy(Json::Value& target,
           assert(it3->second.front() != NULL);
           const Json::Value& firstInstanceInSeries = *it3->second.front();
 
-          if (firstInstanceInSeries.isMember(Orthanc::DICOM_TAG_MODALITY.Format()))
+          if (firstInstanceInSeries.isMember(KEY_MODALITY))
           {
-            modalities.insert(firstInstanceInSeries[Orthanc::DICOM_TAG_MODALITY.Format()].asString());
+            modalities.insert(firstInstanceInSeries[KEY_MODALITY].asString());
           }
 
-          Json::Value series = Json::objectValue;
-          for (TagsDictionary::const_iterator tag = ohifSeriesTags_.begin(); tag != ohifSeriesTags_.end(); ++tag)
+          Json::Value& series = studySeries.append(Json::objectValue);
+          for (FormattedTags::const_iterator tag = ohifSeriesKeys_.begin(); tag != ohifSeriesKeys_.end(); ++tag)
           {
-            if (firstInstanceInSeries.isMember(tag->first.Format()))
+            if (firstInstanceInSeries.isMember(tag->first))
             {
-              series[tag->second.GetName()] = firstInstanceInSeries[tag->first.Format()];
+              series[tag->second] = firstInstanceInSeries[tag->first];
             }
           }
 
+          /**
+           * Default VOI and intensity histogram of the series, if
+           * already computed by the preload thread
+           **/
+          Json::Value voi;
+          const bool hasVoi = GetSeriesVoi(voi, firstInstanceInSeries);
+          if (hasVoi)
+          {
+            series["DefaultVoi"] = Json::objectValue;
+            series["DefaultVoi"]["WindowCenter"] = voi["WindowCenter"];
+            series["DefaultVoi"]["WindowWidth"] = voi["WindowWidth"];
+
+            series["IntensityHistogram"] = Json::objectValue;
+            series["IntensityHistogram"]["Minimum"] = voi["Minimum"];
+            series["IntensityHistogram"]["Maximum"] = voi["Maximum"];
+            series["IntensityHistogram"]["SampledSlices"] = voi["SampledSlices"];
+            series["IntensityHistogram"]["Bins"] = voi["Histogram"];
+          }
+
           series["instances"] = Json::arrayValue;
+          Json::Value& seriesInstances = series["instances"];
 
           for (ListOfResources::const_iterator it4 = it3->second.begin(); it4 != it3->second.end(); ++it4)
           {
             assert(*it4 != NULL);
             const Json::Value& instanceInSeries = **it4;
 
-            Json::Value metadata;
-            for (TagsDictionary::const_iterator tag = ohifInstanceTags_.begin(); tag != ohifInstanceTags_.end(); ++tag)
+            Json::Value& instance = seriesInstances.append(Json::objectValue);
+            Json::Value& metadata = instance["metadata"];
+
+            for (FormattedTags::const_iterator tag = ohifInstanceKeys_.begin(); tag != ohifInstanceKeys_.end(); ++tag)
             {
-              if (instanceInSeries.isMember(tag->first.Format()))
+              if (instanceInSeries.isMember(tag->first))
               {
-                metadata[tag->second.GetName()] = instanceInSeries[tag->first.Format()];
+                metadata[tag->second] = instanceInSeries[tag->first];
               }
             }
 
+            // Instances without a usable VOI would be windowed by OHIF from their pixels
+            if (hasVoi &&
+                (!metadata.isMember("WindowWidth") ||
+                 !metadata["WindowWidth"].isNumeric() ||
+                 metadata["WindowWidth"].asDouble() <= 0))
+            {
+              metadata["WindowCenter"] = voi["WindowCenter"];
+              metadata["WindowWidth"] = voi["WindowWidth"];
+            }
+
             Orthanc::DicomInstanceHasher hasher(instanceInSeries[KEY_PATIENT_ID].asString(),
                                                 instanceInSeries[KEY_STUDY_INSTANCE_UID].asString(),
                                                 instanceInSeries[KEY_SERIES_INSTANCE_UID].asString(),
                                                 instanceInSeries[KEY_SOP_INSTANCE_UID].asString());
 
-            Json::Value instance = Json::objectValue;
-            instance["metadata"] = metadata;
             instance["url"] = "dicomweb:../instances/" + hasher.HashInstance() + "/file";
-
-            series["instances"].append(instance);
             countInstances++;
           }
-
-          study["series"].append(series);
         }
       }
 
@@ -762,10 +1708,8 @@ static void GenerateOhifStudy(Json::Value& target,
 
       study["NumInstances"] = countInstances;
       study["Modalities"] = jsonModalities;
-
-      target["studies"].append(study);
     }
-  }  
+  }
 }
 
 
@@ -787,28 +1731,304 @@ void GetOhifStudy(OrthancPluginRestOutput* output,
 }
 
 
-static void MetadataThread()
+static void MetadataThread(unsigned int thread)
 {
   while (continueThread_)
   {
+    // Both queues are drained by the same threads
+    preloadThrottle_.Update(pendingInstances_.GetSize() + pendingVoiSeries_.GetSize());
+
+    if (!preloadThrottle_.IsActive(thread))
+    {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+      continue;
+    }
+
     std::unique_ptr<Orthanc::IDynamicObject> instance(pendingInstances_.Dequeue(100));
     if (instance.get() != NULL)
     {
       const std::string instanceId = dynamic_cast<Orthanc::SingleValueObject<std::string>&>(*instance).GetValue();
       const std::string uri = GetCacheUri(instanceId);
 
-      Json::Value instanceTags;
+      // The lookup of the cached record is the load probe, not the encoding whose cost depends on the instance
+      const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
       std::string metadata;
-      if (!OrthancPlugins::RestApiGetString(metadata, uri, false) &&
+      const bool isCached = OrthancPlugins::RestApiGetString(metadata, uri, false);
+      preloadThrottle_.AddSample(boost::posix_time::microsec_clock::universal_time() - start);
+
+      Json::Value instanceTags;
+      if (!isCached &&
           EncodeOhifInstance(instanceTags, instanceId))
       {
         CacheAsMetadata(instanceTags, instanceId);
       }
+
+      preloadThrottle_.AddProcessed();
+    }
+    else if (pendingVoiSeries_.GetSize() > 0)
+    {
+      // The OHIF records of the instances take precedence over the VOI of the series
+      std::unique_ptr<Orthanc::IDynamicObject> series(pendingVoiSeries_.Dequeue(100));
+      if (series.get() != NULL)
+      {
+        const std::string seriesId = dynamic_cast<Orthanc::SingleValueObject<std::string>&>(*series).GetValue();
+
+        {
+          // Released before the computation, so that a series that becomes stable again is queued again
+          boost::mutex::scoped_lock lock(queuedVoiSeriesMutex_);
+          queuedVoiSeries_.erase(seriesId);
+        }
+
+        // Same probe as for the instances: the VOI computation downloads and decodes several slices
+        const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        Json::Value cached;
+        const bool hasCached = ReadCompressedMetadata(cached, GetVoiCacheUri(seriesId), VOI_VERSION);
+        preloadThrottle_.AddSample(boost::posix_time::microsec_clock::universal_time() - start);
+
+        UpdateSeriesVoi(seriesId, hasCached, cached);
+        preloadThrottle_.AddProcessed();
+      }
+    }
+    else
+    {
+      continue;
+    }
+
+    const unsigned int pause = preloadThrottle_.GetPause();
+    if (pause > 0)
+    {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(pause));
+    }
+  }
+}
+
+
+static bool GetStudySummary(Json::Value& target,
+                            const std::string& studyId)
+{
+  Json::Value study;
+  if (!OrthancPlugins::RestApiGet(study, "/studies/" + studyId + "?requestedTags=ModalitiesInStudy", false) ||
+      study.type() != Json::objectValue)
+  {
+    // The study was deleted in the meantime
+    return false;
+  }
+
+  target = Json::objectValue;
+  target["ID"] = studyId;
+
+  // Same fields as the studies generated by "GenerateOhifStudy()"
+  for (TagsDictionary::const_iterator tag = ohifStudyTags_.begin(); tag != ohifStudyTags_.end(); ++tag)
+  {
+    const std::string& name = tag->second.GetName();
+
+    if (study.isMember("MainDicomTags") &&
+        study["MainDicomTags"].isMember(name))
+    {
+      target[name] = study["MainDicomTags"][name];
+    }
+    else if (study.isMember("PatientMainDicomTags") &&
+             study["PatientMainDicomTags"].isMember(name))
+    {
+      target[name] = study["PatientMainDicomTags"][name];
+    }
+  }
+
+  if (study.isMember("RequestedTags") &&
+      study["RequestedTags"].isMember("ModalitiesInStudy") &&
+      study["RequestedTags"]["ModalitiesInStudy"].type() == Json::stringValue)
+  {
+    std::string modalities = study["RequestedTags"]["ModalitiesInStudy"].asString();
+    std::replace(modalities.begin(), modalities.end(), '\\', ',');
+    target["Modalities"] = modalities;
+  }
+
+  if (study.isMember("Series") &&
+      study["Series"].type() == Json::arrayValue)
+  {
+    target["NumSeries"] = study["Series"].size();
+  }
+
+  if (study.isMember("IsStable"))
+  {
+    target["IsStable"] = study["IsStable"];
+  }
+
+  if (study.isMember("LastUpdate"))
+  {
+    target["LastUpdate"] = study["LastUpdate"];
+  }
+
+  return true;
+}
+
+
+static void AddPendingChange(const std::string& studyId,
+                             const std::string& seriesId,
+                             unsigned int change)
+{
+  boost::mutex::scoped_lock lock(pendingChangesMutex_);
+
+  if (pendingStudies_.size() + pendingSeries_.size() >= MAX_PENDING_STUDY_CHANGES)
+  {
+    // Massive ingestion: the clients will reload their study list at once
+    pendingStudies_.clear();
+    pendingSeries_.clear();
+    pendingOverflow_ = true;
+  }
+  else if (!studyId.empty())
+  {
+    pendingStudies_[studyId] |= change;
+  }
+  else
+  {
+    // The parent study is looked up by "StudyEventsThread()"
+    pendingSeries_.insert(seriesId);
+  }
+}
+
+
+/**
+ * Coalesces the changes received by "OnChangeCallback()" over
+ * STUDY_EVENTS_COALESCING_MS, then publishes at most one event per
+ * study, together with its summary tags. The REST calls are done
+ * here, not in the callback, so as not to slow down ingestion.
+ **/
+static void StudyEventsThread()
+{
+  while (continueThread_)
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(STUDY_EVENTS_COALESCING_MS));
+
+    std::map<std::string, unsigned int> studies;
+    std::set<std::string> series;
+    bool overflow;
+
+    {
+      boost::mutex::scoped_lock lock(pendingChangesMutex_);
+      studies.swap(pendingStudies_);
+      series.swap(pendingSeries_);
+      overflow = pendingOverflow_;
+      pendingOverflow_ = false;
+    }
+
+    try
+    {
+      if (overflow)
+      {
+        studyEventsBroadcaster_.Publish("resync", Json::objectValue);
+      }
+
+      // A new series means that its parent study was updated
+      for (std::set<std::string>::const_iterator it = series.begin(); it != series.end(); ++it)
+      {
+        Json::Value info;
+        if (OrthancPlugins::RestApiGet(info, "/series/" + *it, false) &&
+            info.type() == Json::objectValue &&
+            info.isMember("ParentStudy") &&
+            info["ParentStudy"].type() == Json::stringValue)
+        {
+          studies[info["ParentStudy"].asString()] |= StudyChange_Updated;
+        }
+      }
+
+      for (std::map<std::string, unsigned int>::const_iterator it = studies.begin(); it != studies.end(); ++it)
+      {
+        Json::Value summary;
+
+        if (it->second & StudyChange_Deleted)
+        {
+          if (!(it->second & StudyChange_New))  // Otherwise, no client has seen this study
+          {
+            summary["ID"] = it->first;
+            studyEventsBroadcaster_.Publish("study-deleted", summary);
+          }
+        }
+        else if (GetStudySummary(summary, it->first))
+        {
+          if (it->second & StudyChange_New)
+          {
+            studyEventsBroadcaster_.Publish("study-new", summary);
+          }
+          else if (it->second & StudyChange_Stable)
+          {
+            studyEventsBroadcaster_.Publish("study-stable", summary);
+          }
+          else
+          {
+            studyEventsBroadcaster_.Publish("study-updated", summary);
+          }
+        }
+      }
+    }
+    catch (Orthanc::OrthancException& e)
+    {
+      ORTHANC_PLUGINS_LOG_ERROR("Cannot publish the OHIF study events: " + std::string(e.What()));
     }
   }
 }
 
 
+/**
+ * Server-sent events for the OHIF study list. As the plugin SDK
+ * cannot stream an answer, each request returns the pending events,
+ * or waits for the next ones until "StudyEventsTimeout". The
+ * "retry" field makes "EventSource" reconnect immediately with the
+ * "Last-Event-ID" header, which resumes the stream where it stopped.
+ * Clients turned away because "StudyEventsMaxWaiters" are already
+ * waiting are told to retry after "StudyEventsTimeout" instead, so
+ * that they back off rather than poll.
+ **/
+void GetStudyEvents(OrthancPluginRestOutput* output,
+                    const char* url,
+                    const OrthancPluginHttpRequest* request)
+{
+  OrthancPluginContext* context = OrthancPlugins::GetGlobalContext();
+
+  bool hasCursor = false;
+  uint64_t since = 0;
+
+  for (uint32_t i = 0; i < request->headersCount; i++)
+  {
+    if (std::string(request->headersKeys[i]) == "last-event-id")  // Keys are lower-cased by Orthanc
+    {
+      hasCursor = Orthanc::SerializationToolbox::ParseUnsignedInteger64(since, request->headersValues[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < request->getCount && !hasCursor; i++)
+  {
+    if (std::string(request->getKeys[i]) == "since")
+    {
+      hasCursor = Orthanc::SerializationToolbox::ParseUnsignedInteger64(since, request->getValues[i]);
+    }
+  }
+
+  if (!hasCursor)
+  {
+    // New client, that has just loaded its study list: only send the next events
+    since = studyEventsBroadcaster_.GetLastSequence();
+  }
+
+  std::string events;
+  uint64_t cursor;
+  bool overloaded;
+  if (!studyEventsBroadcaster_.Collect(events, cursor, overloaded, since,
+                                       studyEventsTimeout_ * 1000, studyEventsMaxWaiters_))
+  {
+    // No event to dispatch, but the client must remember the cursor
+    events += "id: " + boost::lexical_cast<std::string>(cursor) + "\n\n";
+  }
+
+  const unsigned int retry = (overloaded ? std::max(studyEventsTimeout_ * 1000, STUDY_EVENTS_RETRY_MS) :
+                              STUDY_EVENTS_RETRY_MS);
+  std::string s = "retry: " + boost::lexical_cast<std::string>(retry) + "\n\n" + events;
+
+  OrthancPluginSetHttpHeader(context, output, "Cache-Control", "no-cache");
+  OrthancPluginAnswerBuffer(context, output, s.c_str(), s.size(), "text/event-stream");
+}
+
+
 OrthancPluginErrorCode OnChangeCallback(OrthancPluginChangeType changeType,
                                         OrthancPluginResourceType resourceType,
                                         const char* resourceId)
@@ -851,12 +2071,17 @@ OrthancPluginErrorCode OnChangeCallback(OrthancPluginChangeType changeType,
           {
             if (preload_)
             {
-              metadataThread_ = boost::thread(MetadataThread);
-              ORTHANC_PLUGINS_LOG_INFO("Started the OHIF preload thread");
+              const unsigned int countThreads = preloadThrottle_.GetMaxConcurrency();
+              for (unsigned int i = 0; i < countThreads; i++)
+              {
+                metadataThreads_.create_thread(boost::bind(MetadataThread, i));
+              }
+
+              ORTHANC_PLUGINS_LOG_INFO("Started " + boost::lexical_cast<std::string>(countThreads) + " OHIF preload thread(s)");
             }
             else
             {
-              ORTHANC_PLUGINS_LOG_INFO("The OHIF preload thread was not started, as indicated in the configuration file");
+              ORTHANC_PLUGINS_LOG_INFO("The OHIF preload threads were not started, as indicated in the configuration file");
             }
             break;
           }
@@ -864,6 +2089,12 @@ OrthancPluginErrorCode OnChangeCallback(OrthancPluginChangeType changeType,
           default:
             throw Orthanc::OrthancException(Orthanc::ErrorCode_ParameterOutOfRange);
         }
+
+        if (studyEvents_)
+        {
+          studyEventsThread_ = boost::thread(StudyEventsThread);
+          ORTHANC_PLUGINS_LOG_INFO("Started the OHIF study events thread");
+        }
         
         break;
       }
@@ -872,17 +2103,25 @@ OrthancPluginErrorCode OnChangeCallback(OrthancPluginChangeType changeType,
       {
         continueThread_ = false;
 
-        if (metadataThread_.joinable())
+        if (metadataThreads_.size() > 0)
         {
-          ORTHANC_PLUGINS_LOG_INFO("Stopping the OHIF preload thread");
-          metadataThread_.join();
+          ORTHANC_PLUGINS_LOG_INFO("Stopping the OHIF preload threads");
+          metadataThreads_.join_all();
+        }
+
+        studyEventsBroadcaster_.Stop();
+
+        if (studyEventsThread_.joinable())
+        {
+          ORTHANC_PLUGINS_LOG_INFO("Stopping the OHIF study events thread");
+          studyEventsThread_.join();
         }
         break;
       }
 
       case OrthancPluginChangeType_NewInstance:
       {
-        if (metadataThread_.joinable() &&
+        if (metadataThreads_.size() > 0 &&
             pendingInstances_.GetSize() < MAX_INSTANCES_IN_QUEUE) /* avoid overwhelming Orthanc */
         {
           pendingInstances_.Enqueue(new Orthanc::SingleValueObject<std::string>(resourceId));
@@ -891,6 +2130,54 @@ OrthancPluginErrorCode OnChangeCallback(OrthancPluginChangeType changeType,
         break;
       }
 
+      case OrthancPluginChangeType_StableSeries:
+      {
+        EnqueueSeriesVoi(resourceId);
+        break;
+      }
+
+      case OrthancPluginChangeType_NewStudy:
+      {
+        if (studyEventsThread_.joinable())
+        {
+          AddPendingChange(resourceId, "", StudyChange_New);
+        }
+        break;
+      }
+
+      case OrthancPluginChangeType_NewSeries:
+      {
+        /**
+         * The new instances of a study are coalesced at the series
+         * level, which avoids one REST call per instance to find
+         * their parent study.
+         **/
+        if (studyEventsThread_.joinable())
+        {
+          AddPendingChange("", resourceId, StudyChange_Updated);
+        }
+        break;
+      }
+
+      case OrthancPluginChangeType_StableStudy:
+      {
+        if (studyEventsThread_.joinable())
+        {
+          AddPendingChange(resourceId, "", StudyChange_Stable);
+        }
+        break;
+      }
+
+      case OrthancPluginChangeType_Deleted:
+      {
+        if (studyEventsThread_.joinable() &&
+            resourceType == OrthancPluginResourceType_Study)
+        {
+          AddPendingChange(resourceId, "", StudyChange_Deleted);
+        }
+        break;
+      }
+
       default:
         break;
     }
@@ -947,6 +2234,13 @@ extern "C"
       std::string s = configuration.GetStringValue("DataSource", "dicom-web");
       std::string userConfigurationPath = configuration.GetStringValue("UserConfiguration", "");
       preload_ = configuration.GetBooleanValue("Preload", true);
+      precomputeVoi_ = configuration.GetBooleanValue("PrecomputeVoi", true);
+      preloadThrottle_.Configure(configuration.GetUnsignedIntegerValue("PreloadTargetLatency", 100),  // In milliseconds
+                                 configuration.GetUnsignedIntegerValue("PreloadMaxConcurrency", 4));
+      studyEvents_ = configuration.GetBooleanValue("StudyEvents", true);
+      studyEventsTimeout_ = configuration.GetUnsignedIntegerValue("StudyEventsTimeout", 10);  // In seconds
+      studyEventsMaxWaiters_ = configuration.GetUnsignedIntegerValue("StudyEventsMaxWaiters", 16);
+      studyEventsBroadcaster_.SetCapacity(configuration.GetUnsignedIntegerValue("StudyEventsBufferSize", 1000));
 
       static const std::string SOURCE_DICOM_WEB = "dicom-web";
       static const std::string SOURCE_DICOM_JSON = "dicom-json";
@@ -988,6 +2282,11 @@ extern "C"
       OrthancPlugins::RegisterRestCallback<ServeFile>("/ohif/(.*)", true);
       OrthancPlugins::RegisterRestCallback<GetOhifStudy>("/studies/([0-9a-f-]+)/ohif-dicom-json", true);
 
+      if (studyEvents_)
+      {
+        OrthancPlugins::RegisterRestCallback<GetStudyEvents>("/ohif-events", true);
+      }
+
       OrthancPluginRegisterOnChangeCallback(context, OnChangeCallback);
 
       {
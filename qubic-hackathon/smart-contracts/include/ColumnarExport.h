@@ -0,0 +1,217 @@
+#pragma once
+
+#include "types.h"
+#include <algorithm>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// COLUMNAR FORMAT
+// ============================================================================
+
+/**
+ * Columnar export format
+ *
+ * Buffers follow the Arrow columnar layout: little-endian fixed-width
+ * values, variable-length strings as (rows + 1) u32 offsets followed by
+ * the concatenated bytes, every buffer padded to 8 bytes. Framing is a
+ * self-describing stream of u64 words:
+ *
+ *   File   := "UCCOLv1\n" Table* u64(0)
+ *   Table  := u64(1) Str(name) u64(columns) [u64(type) Str(name)]* Batch* u64(0)
+ *   Batch  := u64(rows > 0) [u64(bytes) buffer]*   (one buffer per column)
+ *   Str    := u64(length) bytes, padded to 8
+ */
+constexpr uint32 COLUMNAR_BATCH_ROWS = 65536;  // Rows per record batch
+
+enum class ColumnType : uint8 {
+    UINT8 = 0,
+    UINT32 = 1,
+    UINT64 = 2,
+    STRING = 3
+};
+
+/**
+ * Column definition over a row type
+ * Fixed-width columns set `integer`, STRING columns set `text`
+ */
+template <typename Row>
+struct Column {
+    std::string name;
+    ColumnType type;
+    std::function<uint64(const Row&)> integer;
+    std::function<const std::string&(const Row&)> text;
+};
+
+template <typename Row>
+Column<Row> integerColumn(const std::string& name, ColumnType type,
+                          std::function<uint64(const Row&)> value) {
+    return Column<Row>{name, type, std::move(value), nullptr};
+}
+
+template <typename Row>
+Column<Row> textColumn(const std::string& name,
+                       std::function<const std::string&(const Row&)> value) {
+    return Column<Row>{name, ColumnType::STRING, nullptr, std::move(value)};
+}
+
+/**
+ * Builds one column buffer of a record batch
+ */
+class ColumnEncoder {
+public:
+    ColumnEncoder(ColumnType type, size_t rows);
+
+    void addInteger(uint64 value);
+    void addText(const std::string& value);
+
+    /**
+     * @return Padded buffer in the export layout
+     */
+    std::string finish();
+
+private:
+    ColumnType type;
+    std::string values;  // Fixed-width values, or string offsets
+    std::string data;    // String bytes
+};
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+/**
+ * Columnar Writer
+ *
+ * Streams tables to an output stream one record batch at a time; the
+ * columns of each batch are encoded in parallel.
+ */
+class ColumnarWriter {
+public:
+    /**
+     * @param out Destination stream (binary)
+     * @param workers Encoding threads (0 = hardware concurrency)
+     * @param batchRows Rows per record batch
+     */
+    explicit ColumnarWriter(std::ostream& out, uint32 workers = 0,
+                            uint32 batchRows = COLUMNAR_BATCH_ROWS);
+
+    /**
+     * Write one table
+     * @param name Table name
+     * @param rows Rows in export order
+     * @param columns Column definitions
+     */
+    template <typename Row>
+    void writeTable(const std::string& name, const std::vector<Row>& rows,
+                    const std::vector<Column<Row>>& columns);
+
+    /**
+     * Terminate the file
+     * @return True if every write succeeded
+     */
+    bool finish();
+
+    /**
+     * Export counters
+     */
+    struct Stats {
+        uint64 tables;
+        uint64 rows;
+        uint64 bytes;
+        uint64 elapsedNanos;
+    };
+
+    /**
+     * Get export statistics
+     */
+    Stats getStats() const;
+
+private:
+    std::ostream& out;
+    uint32 workers;
+    uint32 batchRows;
+    Stats stats;
+
+    // Helper methods
+    void beginTable(const std::string& name,
+                    const std::vector<std::pair<std::string, ColumnType>>& schema);
+    void writeBatch(uint64 rows, const std::vector<std::string>& buffers);
+    void endTable();
+    void writeWord(uint64 value);
+    void writeBytes(const std::string& bytes);
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) const;
+    uint64 now() const;
+};
+
+template <typename Row>
+void ColumnarWriter::writeTable(const std::string& name, const std::vector<Row>& rows,
+                                const std::vector<Column<Row>>& columns) {
+    uint64 start = now();
+
+    std::vector<std::pair<std::string, ColumnType>> schema;
+    for (const auto& column : columns) {
+        schema.emplace_back(column.name, column.type);
+    }
+    beginTable(name, schema);
+
+    std::vector<std::string> buffers(columns.size());
+    for (size_t begin = 0; begin < rows.size(); begin += batchRows) {
+        size_t end = std::min(rows.size(), begin + static_cast<size_t>(batchRows));
+
+        parallelFor(columns.size(), [&](size_t c) {
+            const Column<Row>& column = columns[c];
+            ColumnEncoder encoder(column.type, end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                if (column.type == ColumnType::STRING) {
+                    encoder.addText(column.text(rows[i]));
+                } else {
+                    encoder.addInteger(column.integer(rows[i]));
+                }
+            }
+            buffers[c] = encoder.finish();
+        });
+
+        writeBatch(end - begin, buffers);
+    }
+
+    endTable();
+    stats.rows += rows.size();
+    stats.elapsedNanos += now() - start;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+/**
+ * Decoded table (whole table in memory)
+ */
+struct ColumnarTable {
+    std::string name;
+    std::vector<std::string> columnNames;
+    std::vector<ColumnType> columnTypes;
+    std::vector<std::vector<uint64>> integers;     // Per column, empty for STRING
+    std::vector<std::vector<std::string>> strings; // Per column, empty otherwise
+    uint64 rows;
+
+    /**
+     * Get index of a column by name
+     * @return Column index, or columnNames.size() if absent
+     */
+    size_t columnIndex(const std::string& column) const;
+};
+
+/**
+ * Read a columnar export
+ * @param in Source stream (binary)
+ * @param tables Decoded tables
+ * @return False if the stream is truncated or malformed
+ */
+bool readColumnar(std::istream& in, std::vector<ColumnarTable>& tables);
+
+}  // namespace UCIC
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "types.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// EPOCH CONSTANTS
+// ============================================================================
+
+constexpr uint64 STATS_EPOCH_SECONDS = 24 * 3600;  // One aggregate per day
+constexpr uint32 STATS_RETAINED_EPOCHS = 90;        // Older epochs are dropped
+constexpr uint32 SKETCH_SUB_BUCKETS = 8;            // Per power of two: <= 12.5% relative error
+
+// ============================================================================
+// LATENCY SKETCH
+// ============================================================================
+
+/**
+ * Latency Sketch
+ *
+ * Log-linear histogram: exact below SKETCH_SUB_BUCKETS, then each power of
+ * two is split into SKETCH_SUB_BUCKETS buckets. Quantiles are within
+ * 1 / SKETCH_SUB_BUCKETS relative error, and two sketches merge by adding
+ * bucket counts, so per-epoch sketches combine into any window.
+ */
+class LatencySketch {
+public:
+    LatencySketch();
+
+    /**
+     * Record one observation
+     * @param value Observed latency (any unit)
+     */
+    void add(uint64 value);
+
+    /**
+     * Add another sketch's observations to this one
+     */
+    void merge(const LatencySketch& other);
+
+    /**
+     * Get approximate quantile
+     * @param q Quantile in [0, 1] (0.5 = median)
+     * @return Upper bound of the bucket holding the quantile, 0 if empty
+     */
+    uint64 quantile(double q) const;
+
+    uint64 getCount() const;
+    uint64 getMin() const;
+    uint64 getMax() const;
+
+private:
+    std::vector<uint64> buckets;  // Grown to the highest bucket used
+    uint64 count;
+    uint64 minValue;
+    uint64 maxValue;
+
+    static uint32 bucketOf(uint64 value);
+    static uint64 bucketUpper(uint32 bucket);
+};
+
+// ============================================================================
+// EPOCH SERIES
+// ============================================================================
+
+/**
+ * Epoch Series
+ *
+ * Per-epoch aggregates maintained incrementally as events happen; T must
+ * be default-constructible and provide merge(const T&). Only the newest
+ * retainedEpochs epochs are kept. Events older than that are folded into
+ * the oldest retained epoch.
+ */
+template <typename T>
+class EpochSeries {
+public:
+    /**
+     * @param epochSeconds Epoch length in seconds
+     * @param retainedEpochs Epochs kept
+     */
+    explicit EpochSeries(uint64 epochSeconds = STATS_EPOCH_SECONDS,
+                         uint32 retainedEpochs = STATS_RETAINED_EPOCHS)
+        : epochSeconds(epochSeconds > 0 ? epochSeconds : 1),
+          retainedEpochs(retainedEpochs > 0 ? retainedEpochs : 1),
+          firstEpoch(0) {}
+
+    /**
+     * Get the epoch number of a timestamp
+     */
+    uint64 epochOf(Timestamp timestamp) const {
+        return timestamp / epochSeconds;
+    }
+
+    /**
+     * Get the writable aggregate of the epoch containing a timestamp
+     * Advancing to a new epoch drops epochs beyond retention
+     * @param timestamp Event time
+     * @return Aggregate to update
+     */
+    T& at(Timestamp timestamp) {
+        uint64 epoch = epochOf(timestamp);
+        if (epochs.empty() || epoch >= firstEpoch + epochs.size() + retainedEpochs) {
+            epochs.clear();
+            epochs.emplace_back();
+            firstEpoch = epoch;
+            return epochs.back();
+        }
+        if (epoch < firstEpoch) {
+            return epochs.front();
+        }
+        while (epoch >= firstEpoch + epochs.size()) {
+            epochs.emplace_back();
+        }
+        while (epochs.size() > retainedEpochs) {
+            epochs.pop_front();
+            firstEpoch++;
+        }
+        return epochs[static_cast<size_t>(epoch - firstEpoch)];
+    }
+
+    /**
+     * Merge the aggregates of a rolling window, O(epochs)
+     * @param now End of the window (its epoch is included)
+     * @param count Number of epochs, ending with the epoch of now
+     * @return Merged aggregate (empty epochs contribute nothing)
+     */
+    T window(Timestamp now, uint32 count) const {
+        T result;
+        uint64 last = epochOf(now);
+        uint64 first = last + 1 >= count ? last + 1 - count : 0;
+        for (uint64 epoch = std::max(first, firstEpoch);
+             epoch <= last && epoch < firstEpoch + epochs.size(); ++epoch) {
+            result.merge(epochs[static_cast<size_t>(epoch - firstEpoch)]);
+        }
+        return result;
+    }
+
+    /**
+     * Get the aggregate of one retained epoch
+     * @param epoch Epoch number
+     * @return Aggregate, empty if the epoch is not retained
+     */
+    T get(uint64 epoch) const {
+        if (epoch < firstEpoch || epoch >= firstEpoch + epochs.size()) {
+            return T();
+        }
+        return epochs[static_cast<size_t>(epoch - firstEpoch)];
+    }
+
+    /**
+     * Get number of retained epochs
+     */
+    size_t size() const {
+        return epochs.size();
+    }
+
+private:
+    uint64 epochSeconds;
+    uint32 retainedEpochs;
+    uint64 firstEpoch;
+    std::deque<T> epochs;
+};
+
+}  // namespace UCIC
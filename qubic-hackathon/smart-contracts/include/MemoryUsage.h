@@ -0,0 +1,183 @@
+#pragma once
+
+#include "types.h"
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// MEMORY ACCOUNTING
+// ============================================================================
+
+/**
+ * Usage of one internal data structure
+ *
+ * Bytes are approximate: container nodes and buckets, vector capacity and
+ * heap-allocated string buffers, using libstdc++ node layouts. Allocator
+ * headers and fragmentation are not counted.
+ */
+struct StructureUsage {
+    std::string name;
+    uint64 entries;
+    uint64 bytes;
+};
+
+/**
+ * Memory report of one contract
+ * Contracts keep their counters current as they write, so taking a report
+ * reads them in O(1) per structure and can be sampled at any rate.
+ */
+struct MemoryUsage {
+    std::string contract;
+    std::vector<StructureUsage> structures;
+
+    void add(const std::string& name, uint64 entries, uint64 bytes);
+
+    /**
+     * Get total approximate bytes over all structures
+     */
+    uint64 totalBytes() const;
+};
+
+/**
+ * Write reports in the Prometheus text exposition format
+ * Gauges: ucic_structure_entries and ucic_structure_bytes, labelled by
+ * contract and structure
+ * @param out Destination stream
+ * @param reports Reports to export
+ */
+void writeMemoryMetrics(std::ostream& out, const std::vector<MemoryUsage>& reports);
+
+// ============================================================================
+// SIZE ESTIMATES
+// ============================================================================
+
+constexpr uint64 TREE_NODE_OVERHEAD = 4 * sizeof(void*);     // Colour, parent, left, right
+constexpr uint64 HASH_NODE_OVERHEAD = 2 * sizeof(void*);     // Next pointer, cached hash
+constexpr uint64 SHARED_BLOCK_OVERHEAD = 2 * sizeof(void*);  // make_shared control block
+
+/**
+ * Heap bytes owned by a value beyond sizeof(value)
+ * Containers add their element storage; records add their strings and vectors.
+ */
+uint64 heapBytes(const std::string& value);
+inline uint64 heapBytes(uint64) { return 0; }
+inline uint64 heapBytes(uint32) { return 0; }
+inline uint64 heapBytes(uint8) { return 0; }
+inline uint64 heapBytes(bool) { return 0; }
+inline uint64 heapBytes(const Hash256&) { return 0; }
+inline uint64 heapBytes(const VotingCheckpoint&) { return 0; }
+uint64 heapBytes(const Account& account);
+uint64 heapBytes(const AuditTrailChunk& chunk);
+uint64 heapBytes(const Contributor& contributor);
+uint64 heapBytes(const CategoryScore& score);
+uint64 heapBytes(const OracleSubmission& submission);
+uint64 heapBytes(const Proposal& proposal);
+uint64 heapBytes(const Vote& vote);
+uint64 heapBytes(const WalRecord& record);
+uint64 heapBytes(const TransferRecord& record);
+
+template <typename A, typename B>
+uint64 heapBytes(const std::pair<A, B>& value) {
+    return heapBytes(value.first) + heapBytes(value.second);
+}
+
+/**
+ * Storage of a container itself: nodes, buckets or capacity, excluding
+ * what its elements own. O(1), so reports can add it at sampling time.
+ */
+template <typename T>
+uint64 containerBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+template <typename T>
+uint64 containerBytes(const std::deque<T>& values) {
+    return values.size() * sizeof(T);
+}
+
+template <typename K, typename V, typename C>
+uint64 containerBytes(const std::map<K, V, C>& values) {
+    return values.size() * (TREE_NODE_OVERHEAD + sizeof(std::pair<const K, V>));
+}
+
+template <typename K, typename C>
+uint64 containerBytes(const std::set<K, C>& values) {
+    return values.size() * (TREE_NODE_OVERHEAD + sizeof(K));
+}
+
+template <typename K, typename V, typename H, typename E>
+uint64 containerBytes(const std::unordered_map<K, V, H, E>& values) {
+    return values.bucket_count() * sizeof(void*) +
+           values.size() * (HASH_NODE_OVERHEAD + sizeof(std::pair<const K, V>));
+}
+
+template <typename T>
+uint64 heapBytes(const std::vector<T>& values) {
+    uint64 bytes = containerBytes(values);
+    for (const auto& value : values) {
+        bytes += heapBytes(value);
+    }
+    return bytes;
+}
+
+template <typename T>
+uint64 heapBytes(const std::deque<T>& values) {
+    uint64 bytes = containerBytes(values);
+    for (const auto& value : values) {
+        bytes += heapBytes(value);
+    }
+    return bytes;
+}
+
+template <typename K, typename V, typename C>
+uint64 heapBytes(const std::map<K, V, C>& values) {
+    uint64 bytes = containerBytes(values);
+    for (const auto& value : values) {
+        bytes += heapBytes(value.first) + heapBytes(value.second);
+    }
+    return bytes;
+}
+
+template <typename K, typename C>
+uint64 heapBytes(const std::set<K, C>& values) {
+    uint64 bytes = containerBytes(values);
+    for (const auto& value : values) {
+        bytes += heapBytes(value);
+    }
+    return bytes;
+}
+
+template <typename K, typename V, typename H, typename E>
+uint64 heapBytes(const std::unordered_map<K, V, H, E>& values) {
+    uint64 bytes = containerBytes(values);
+    for (const auto& value : values) {
+        bytes += heapBytes(value.first) + heapBytes(value.second);
+    }
+    return bytes;
+}
+
+/**
+ * Running totals of one structure, kept by its writer
+ * Entries and the heap its elements own (strings, nested vectors) are
+ * updated on every insert, erase and in-place resize, so a report adds
+ * containerBytes() and never walks the elements.
+ */
+struct StructureCounter {
+    uint64 entries = 0;
+    uint64 bytes = 0;
+
+    void insert(uint64 heap = 0) { entries++; bytes += heap; }
+    void erase(uint64 heap = 0) { entries--; bytes -= heap; }
+    void resize(uint64 before, uint64 after) { bytes += after - before; }
+    void clear() { entries = 0; bytes = 0; }
+};
+
+}  // namespace UCIC
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "types.h"
+#include "TransactionAuth.h"
+#include "UCTokenContract.h"
+#include "UCICDaoContract.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// MEMPOOL CONSTANTS
+// ============================================================================
+
+constexpr uint64 MEMPOOL_CAPACITY = 100000;  // Pending transactions kept in memory
+constexpr uint32 BLOCK_SIZE = 512;           // Transactions per block
+constexpr uint32 MEMPOOL_PURGE_ATTEMPTS = 8; // Unverified entries checked per admission under pressure
+
+enum class AdmissionResult : uint8 {
+    ACCEPTED = 0,
+    REPLACED = 1,     // Replaced a pending transaction with the same nonce
+    DUPLICATE = 2,
+    UNDERPRICED = 3,  // Fee too low to replace or to displace under pressure
+    INVALID = 4       // Malformed, nonce already used, or a forged replacement
+};
+
+/**
+ * Mempool
+ *
+ * Pending signed token and DAO operations awaiting block inclusion.
+ * Features:
+ *  - Per-sender queues ordered by Account::nonce
+ *  - Duplicate rejection and replace-by-fee on (sender, nonce)
+ *  - Bounded memory: the lowest-fee transactions are evicted first
+ *  - A transaction only replaces or displaces another once its signature
+ *    has been verified against the sender's bound key; a forged entry
+ *    found in the way is dropped instead, whatever its fee
+ *  - Fee-prioritized fixed-size blocks that never reorder a sender's nonces
+ *
+ * add() may be called from any thread. buildBlock() must run on the thread
+ * that executes blocks, since it reads nonces from the token contract.
+ */
+class Mempool {
+public:
+    /**
+     * @param token Token contract providing bound keys (read from any thread)
+     * @param capacity Pending transactions kept
+     * @param blockSize Transactions per block
+     */
+    explicit Mempool(std::shared_ptr<const UCTokenContract> token,
+                     uint64 capacity = MEMPOOL_CAPACITY, uint32 blockSize = BLOCK_SIZE);
+
+    /**
+     * Admit a transaction
+     * Signatures are checked at block verification, except for a
+     * transaction that would replace or displace another
+     * @param tx Signed transaction envelope
+     * @return Admission outcome
+     */
+    AdmissionResult add(const SignedTransaction& tx);
+
+    /**
+     * Remove the next block of executable transactions
+     * Senders' next nonces are tracked across blocks still in flight
+     * @param token Token contract providing on-chain nonces
+     * @return Up to blockSize transactions, empty if nothing is ready
+     */
+    std::vector<SignedTransaction> buildBlock(const UCTokenContract& token);
+
+    /**
+     * Forget the tracked nonce of a sender after one of its transactions
+     * failed, so the next block re-reads it from the token contract
+     * @param sender Sender address
+     */
+    void resync(const PublicAddress& sender);
+
+    /**
+     * Get number of pending transactions
+     */
+    uint64 size() const;
+
+    /**
+     * Mempool counters (cumulative)
+     */
+    struct Stats {
+        uint64 admitted;
+        uint64 replaced;
+        uint64 rejected;
+        uint64 evicted;
+        uint64 included;
+    };
+
+    /**
+     * Get mempool statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        SignedTransaction tx;
+        uint64 sequence;  // Arrival order, breaks fee ties
+        bool verified;    // Signed by the sender's bound key (checked on conflict)
+    };
+
+    struct SenderQueue {
+        std::map<uint64, Entry> pending;  // nonce -> entry
+        uint64 nextNonce;
+        bool tracked;
+
+        SenderQueue() : nextNonce(0), tracked(false) {}
+    };
+
+    // (fee, sender, nonce): ascending, so the first entry is evicted first
+    using FeeKey = std::tuple<uint64, PublicAddress, uint64>;
+
+    std::shared_ptr<const UCTokenContract> token;
+    mutable std::mutex mutex;
+    std::map<PublicAddress, SenderQueue> senders;
+    std::set<FeeKey> byFee;
+    std::set<FeeKey> unverified;  // Entries never checked against the bound key
+
+    uint64 capacity;
+    uint32 blockSize;
+    uint64 count;
+    uint64 sequence;
+    Stats stats;
+
+    // Helper methods
+    bool isGenuine(const SignedTransaction& tx) const;
+    bool checkEntry(Entry& entry);
+    Entry* findEntry(const FeeKey& key);
+    void evict(const FeeKey& key);
+    void erase(SenderQueue& queue, std::map<uint64, Entry>::iterator it);
+};
+
+/**
+ * Block Executor
+ *
+ * Drains a Mempool block by block. Each block's signatures are verified
+ * in batches on worker threads while the previous block executes, so
+ * admission, verification and execution run as a pipeline.
+ */
+class BlockExecutor {
+public:
+    /**
+     * @param tokenContract Token contract (nonces, balances, TRANSFER/APPROVE)
+     * @param daoContract DAO contract for CAST_VOTE (optional)
+     * @param workers Signature verification threads (0 = hardware concurrency)
+     */
+    BlockExecutor(std::shared_ptr<UCTokenContract> tokenContract,
+                  std::shared_ptr<UCICDaoContract> daoContract = nullptr,
+                  uint32 workers = 0);
+
+    /**
+     * Verify the signatures of one block, then execute it
+     * @param block Transactions in block order
+     * @return Per-transaction success
+     */
+    std::vector<bool> executeBlock(const std::vector<SignedTransaction>& block);
+
+    /**
+     * Build, verify and execute blocks until the mempool has nothing ready
+     * @param mempool Source of pending transactions
+     * @return Number of transactions applied
+     */
+    uint64 drain(Mempool& mempool);
+
+    /**
+     * Execution counters (cumulative)
+     */
+    struct Stats {
+        uint64 blocks;
+        uint64 applied;
+        uint64 failed;
+        uint64 elapsedNanos;
+
+        /**
+         * Get end-to-end throughput of drain()
+         * @return Transactions applied per second
+         */
+        double throughput() const;
+    };
+
+    /**
+     * Get execution statistics
+     */
+    Stats getStats() const;
+
+    /**
+     * Get signature verification statistics
+     */
+    BatchVerifier::Stats getVerificationStats() const;
+
+private:
+    std::shared_ptr<UCTokenContract> tokenContract;
+    std::shared_ptr<UCICDaoContract> daoContract;
+    BatchVerifier verifier;
+    Stats stats;
+
+    // Helper methods
+    std::vector<bool> executeVerified(const std::vector<SignedTransaction>& block,
+                                      const std::vector<bool>& verified);
+    bool apply(const SignedTransaction& tx);
+};
+
+}  // namespace UCIC
@@ -3,6 +3,10 @@
 #include "types.h"
 #include "UCTokenContract.h"
 #include "UCICDaoContract.h"
+#include "ColumnarExport.h"
+#include "EpochStats.h"
+#include "MemoryUsage.h"
+#include "SegmentedLog.h"
 #include <vector>
 #include <map>
 #include <set>
@@ -211,6 +215,18 @@ public:
                                 const PublicAddress& actor,
                                 const TransactionHash& submissionId);
     
+    /**
+     * Get the audit log
+     * Recent records are resident; older segments are archived as Merkle roots
+     */
+    const SegmentedLog& getAuditLog() const;
+    
+    /**
+     * Set how many sealed audit log segments stay resident
+     * @param retainedSegments Sealed segments kept before compaction
+     */
+    void setLogRetention(uint32 retainedSegments);
+    
     // ========================================================================
     // VERIFIER MANAGEMENT
     // ========================================================================
@@ -318,13 +334,15 @@ public:
     
     /**
      * Get current oracle statistics
+     * Reads running totals kept by the writers: O(1) regardless of history size
      * @return Statistics structure
      */
     Statistics getStatistics() const;
     
     /**
      * Get verification timeline
-     * Average time from submission to verification
+     * Average time from submission to the latest verification, over the
+     * submissions verified after they were submitted; O(1)
      * @return Time in seconds
      */
     uint64 getAverageVerificationTime() const;
@@ -335,6 +353,61 @@ public:
      * @return Acceptance rate 0-100
      */
     uint8 getAcceptanceRate() const;
+    
+    /**
+     * Oracle activity aggregated over one epoch, or merged over a window
+     */
+    struct EpochStats {
+        uint64 submissions;
+        uint64 verifications;
+        uint64 acceptedVerifications;
+        uint64 challenges;
+        LatencySketch verificationLatency;  // Seconds from submission to each verification
+        
+        EpochStats() 
+            : submissions(0), verifications(0), acceptedVerifications(0), challenges(0) {}
+        
+        void merge(const EpochStats& other) {
+            submissions += other.submissions;
+            verifications += other.verifications;
+            acceptedVerifications += other.acceptedVerifications;
+            challenges += other.challenges;
+            verificationLatency.merge(other.verificationLatency);
+        }
+        
+        /**
+         * Percentage of verifications that approved, 0-100
+         */
+        uint8 acceptanceRate() const {
+            return verifications == 0 ? 0 :
+                static_cast<uint8>((acceptedVerifications * 100) / verifications);
+        }
+    };
+    
+    /**
+     * Get activity over the most recent epochs (daily), current one included
+     * Maintained incrementally; O(epochs)
+     * @param epochs Window length in epochs
+     * @return Merged aggregate, with latency percentiles over the window
+     */
+    EpochStats getRollingStats(uint32 epochs) const;
+    
+    /**
+     * Report entry counts and approximate bytes per internal structure
+     * Reads counters kept by the writers: O(1) regardless of history size
+     * Must run on the thread that mutates the contract
+     * @return Memory report (contract "oracle")
+     */
+    MemoryUsage getMemoryUsage() const;
+    
+    /**
+     * Export oracle state in columnar form
+     * Tables: submissions, verifications (one row per verification record)
+     * and verifiers (with verification counts). Must run on the thread that
+     * mutates the contract.
+     * @param writer Destination writer
+     */
+    void exportColumnar(ColumnarWriter& writer) const;
 
 private:
     std::shared_ptr<UCICDaoContract> daoContract;
@@ -345,18 +418,35 @@ private:
     std::map<PublicAddress, std::string> gitRepositories;
     std::map<TransactionHash, Hash256> merkleRoots;
     std::set<PublicAddress> verifiers;
-    std::vector<TransactionHash> auditLog;
+    SegmentedLog auditLog;
     
     // Challenge tracking
     std::map<TransactionHash, bool> challenges;
     
     uint64 totalVerifications;
     uint64 acceptedVerifications;
+    EpochSeries<EpochStats> epochStats;
+    
+    // Running totals of getStatistics()
+    std::array<uint64, 4> submissionsByLevel;  // Indexed by VerificationLevel
+    uint64 pendingChallengeCount;
+    uint64 verificationTimeTotal;  // Seconds, see getAverageVerificationTime()
+    uint64 verificationTimeCount;
+    
+    // Memory accounting, kept current by the writers (see getMemoryUsage())
+    StructureCounter submissionUsage;
+    StructureCounter verificationUsage;
+    StructureCounter repositoryUsage;
+    StructureCounter merkleRootUsage;
+    StructureCounter verifierUsage;
+    StructureCounter challengeUsage;
     
     // Helper methods
     Hash256 computeMerkleTree(const OracleSubmission& submission) const;
     bool validateScores(uint8 cq, uint8 doc, uint8 test, uint8 innov, uint8 comm) const;
     TransactionHash generateSubmissionId() const;
+    uint64 verificationTime(const TransactionHash& submissionId) const;
+    void countVerificationTime(uint64 before, uint64 after);
 };
 
 }  // namespace UCIC
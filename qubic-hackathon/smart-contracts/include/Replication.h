@@ -0,0 +1,270 @@
+#pragma once
+
+#include "types.h"
+#include "UCTokenContract.h"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// REPLICATION CONSTANTS
+// ============================================================================
+
+constexpr uint32 WAL_MAX_FRAME_SIZE = 1 << 20;           // Larger frames are treated as corrupt
+constexpr uint64 WAL_MAX_BUFFERED_BYTES = 64ULL << 20;   // Per-follower backlog before disconnect
+
+enum class FrameStatus : uint8 {
+    COMPLETE = 0,
+    INCOMPLETE = 1,  // Wait for more bytes
+    CORRUPT = 2      // Bad length or checksum: the stream cannot be resumed
+};
+
+/**
+ * Encode a record as a wire frame
+ * [u32 payload length][payload][u64 checksum], little-endian
+ * @param record Record to encode
+ * @return Frame bytes
+ */
+std::string encodeWalFrame(const WalRecord& record);
+
+/**
+ * Decode one frame from a byte buffer
+ * @param data Buffer start
+ * @param size Bytes available
+ * @param record Decoded record (valid when COMPLETE)
+ * @param consumed Frame size in bytes (valid when COMPLETE)
+ * @return Decoding outcome
+ */
+FrameStatus decodeWalFrame(const char* data, size_t size, WalRecord& record, size_t& consumed);
+
+/**
+ * Queue an acknowledgement (u64 applied sequence, little-endian)
+ * The unsent tail of a partially sent acknowledgement is kept so the
+ * primary stays aligned on 8-byte boundaries; unsent whole
+ * acknowledgements are superseded by the new one
+ * @param outbox Unsent acknowledgement bytes, oldest first
+ * @param appliedSequence Sequence to acknowledge
+ */
+void queueAcknowledgement(std::string& outbox, uint64 appliedSequence);
+
+// ============================================================================
+// REPLICATION LOG
+// ============================================================================
+
+/**
+ * Replication Log
+ *
+ * Ordered commit groups produced by UCTokenContract::commitReplication().
+ * Each group gets the next sequence number and ends with a COMMIT record.
+ * Groups are retained until every follower has been sent them.
+ */
+class ReplicationLog {
+public:
+    ReplicationLog();
+
+    /**
+     * Append a commit group
+     * @param group State records of one commit (sequence is assigned here)
+     * @return Sequence of the new group
+     */
+    uint64 append(std::vector<WalRecord> group);
+
+    /**
+     * Get sequence of the latest commit group
+     */
+    uint64 getLastSequence() const;
+
+    /**
+     * Get records of all retained groups after a sequence
+     * @param afterSequence Last sequence already delivered
+     * @return Records in log order
+     */
+    std::vector<WalRecord> readAfter(uint64 afterSequence) const;
+
+    /**
+     * Drop groups up to and including a sequence
+     * @param throughSequence Last sequence no longer needed
+     */
+    void truncate(uint64 throughSequence);
+
+    /**
+     * Get number of retained records
+     */
+    uint64 size() const;
+
+private:
+    std::deque<WalRecord> records;
+    uint64 lastSequence;
+};
+
+// ============================================================================
+// PRIMARY / FOLLOWER
+// ============================================================================
+
+/**
+ * WAL Shipper
+ *
+ * Primary side of ledger replication. Followers are connected stream
+ * sockets (Unix domain or TCP); a new follower is bootstrapped with a full
+ * state image, then receives every later commit group. Sends never block:
+ * unsent bytes are buffered per follower, and a follower whose backlog
+ * exceeds WAL_MAX_BUFFERED_BYTES is disconnected and must re-bootstrap.
+ *
+ * Must run on the thread that mutates the token contract.
+ */
+class WalShipper {
+public:
+    /**
+     * @param tokenContract Primary ledger (its replication log is attached here)
+     */
+    explicit WalShipper(std::shared_ptr<UCTokenContract> tokenContract);
+    ~WalShipper();
+
+    WalShipper(const WalShipper&) = delete;
+    WalShipper& operator=(const WalShipper&) = delete;
+
+    /**
+     * Connect a follower and queue its bootstrap image
+     * @param fd Connected socket (ownership is taken)
+     * @return Follower ID
+     */
+    uint32 addFollower(int fd);
+
+    /**
+     * Commit pending ledger changes, queue new groups to every follower,
+     * flush what the sockets accept and collect acknowledgements
+     * @return Latest committed sequence
+     */
+    uint64 ship();
+
+    /**
+     * Per-follower replication state
+     */
+    struct FollowerStats {
+        uint32 id;
+        uint64 sentSequence;     // Latest group queued to the follower
+        uint64 appliedSequence;  // Latest group the follower acknowledged
+        uint64 lag;              // Commit groups not yet applied
+        uint64 bufferedBytes;    // Queued but not yet accepted by the socket
+        bool connected;
+    };
+
+    /**
+     * Get replication state of every follower
+     */
+    std::vector<FollowerStats> getFollowerStats() const;
+
+    /**
+     * Shipping counters (cumulative)
+     */
+    struct Stats {
+        uint64 committedSequence;
+        uint64 recordsShipped;
+        uint64 bytesShipped;
+        uint64 bootstraps;
+        uint64 disconnects;
+    };
+
+    /**
+     * Get shipping statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Follower {
+        uint32 id;
+        int fd;
+        uint64 sentSequence;
+        uint64 appliedSequence;
+        std::string outbox;
+        size_t outboxOffset;
+        std::string inbox;  // Partial acknowledgement bytes
+        bool connected;
+    };
+
+    std::shared_ptr<UCTokenContract> tokenContract;
+    std::shared_ptr<ReplicationLog> log;
+    std::vector<Follower> followers;
+    uint32 nextFollowerId;
+    Stats stats;
+
+    // Helper methods
+    void queue(Follower& follower, const std::vector<WalRecord>& records);
+    void flush(Follower& follower);
+    void readAcknowledgements(Follower& follower);
+    void disconnect(Follower& follower);
+};
+
+/**
+ * Follower Replica
+ *
+ * Read-only copy of the ledger fed by a WalShipper. Commit groups are
+ * applied whole, in order, so reads always see a committed primary state.
+ * Each applied group is acknowledged back to the primary.
+ *
+ * poll() and reads of getLedger() must happen on the same thread.
+ */
+class FollowerReplica {
+public:
+    /**
+     * @param fd Connected socket to the primary (ownership is taken)
+     */
+    explicit FollowerReplica(int fd);
+    ~FollowerReplica();
+
+    FollowerReplica(const FollowerReplica&) = delete;
+    FollowerReplica& operator=(const FollowerReplica&) = delete;
+
+    /**
+     * Read whatever has arrived and apply complete commit groups
+     * Never blocks
+     * @return Number of commit groups applied
+     */
+    uint64 poll();
+
+    /**
+     * Get the replicated ledger (read-only)
+     */
+    const UCTokenContract& getLedger() const;
+
+    /**
+     * Check if the bootstrap image has been applied
+     */
+    bool isBootstrapped() const;
+
+    /**
+     * Replica counters
+     */
+    struct Stats {
+        uint64 appliedSequence;
+        uint64 groupsApplied;
+        uint64 recordsApplied;
+        uint64 bytesReceived;
+        uint64 applyLagNanos;  // Primary commit to local apply, latest group
+        bool connected;
+        bool corrupt;
+    };
+
+    /**
+     * Get replica statistics
+     */
+    Stats getStats() const;
+
+private:
+    int fd;
+    UCTokenContract ledger;
+    std::string inbox;
+    std::vector<WalRecord> pending;  // Records of the group being received
+    std::string ackOutbox;           // Unsent acknowledgement bytes
+    bool bootstrapped;
+    Stats stats;
+
+    // Helper methods
+    void applyGroup(const WalRecord& commit);
+    void acknowledge();
+};
+
+}  // namespace UCIC
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "types.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// LOG CONSTANTS
+// ============================================================================
+
+constexpr uint32 LOG_SEGMENT_RECORDS = 1024;     // Records per sealed segment
+constexpr uint32 LOG_RETAINED_SEGMENTS = 8;      // Sealed segments kept resident by default
+
+/**
+ * Fixed-size log record
+ * Action and actor are interned names, the subject (transaction hash,
+ * submission ID) is kept as a digest
+ */
+struct LogRecord {
+    uint64 sequence;     // 1-based, dense
+    Timestamp timestamp;
+    uint32 action;       // See SegmentedLog::getName()
+    uint32 actor;
+    Hash256 subject;     // SegmentedLog::digest(subject)
+
+    LogRecord() : sequence(0), timestamp(0), action(0), actor(0), subject{} {}
+};
+
+/**
+ * Compacted segment: only its Merkle root and range survive
+ */
+struct LogArchive {
+    uint64 firstSequence;
+    uint32 records;
+    Timestamp firstTimestamp;
+    Timestamp lastTimestamp;
+    Hash256 merkleRoot;
+};
+
+/**
+ * Inclusion proof of one record within its segment
+ */
+struct LogProof {
+    uint64 sequence;
+    std::vector<Hash256> siblings;  // Leaf level first
+};
+
+// ============================================================================
+// SEGMENTED LOG
+// ============================================================================
+
+/**
+ * Segmented Log
+ *
+ * Append-only log of fixed-size records. Records fill an active segment;
+ * a full segment is sealed with the Merkle root of its records. Only the
+ * newest sealed segments stay resident: older ones are compacted into a
+ * LogArchive, bounding memory while any record whose proof was taken
+ * before compaction can still be proven against the archived root.
+ * Interned names are reference-counted by resident records, so names
+ * only used by compacted records are released and their IDs reused.
+ */
+class SegmentedLog {
+public:
+    /**
+     * @param segmentRecords Records per segment
+     * @param retainedSegments Sealed segments kept resident
+     */
+    explicit SegmentedLog(uint32 segmentRecords = LOG_SEGMENT_RECORDS,
+                          uint32 retainedSegments = LOG_RETAINED_SEGMENTS);
+
+    /**
+     * Append a record
+     * @param action Action name
+     * @param actor Address performing the action
+     * @param subject Transaction hash or ID the action refers to
+     * @param timestamp Time of the action
+     * @return Sequence of the new record
+     */
+    uint64 append(const std::string& action, const PublicAddress& actor,
+                  const std::string& subject, Timestamp timestamp);
+
+    /**
+     * Change how many sealed segments stay resident
+     * Compacts immediately if fewer are now allowed
+     * @param retainedSegments Sealed segments kept resident
+     */
+    void setRetention(uint32 retainedSegments);
+
+    /**
+     * Look up a resident record
+     * @param sequence Record sequence
+     * @param record Output record
+     * @return False if the record was compacted or never written
+     */
+    bool find(uint64 sequence, LogRecord& record) const;
+
+    /**
+     * Get the newest resident records
+     * @param limit Maximum number of records
+     * @return Records, oldest first
+     */
+    std::vector<LogRecord> getRecent(size_t limit) const;
+
+    /**
+     * Get an interned action or actor name
+     * IDs of compacted records may have been released and reused
+     * @param id Name ID from a resident record
+     * @return Name, empty if unknown
+     */
+    const std::string& getName(uint32 id) const;
+
+    /**
+     * Build the inclusion proof of a record in a sealed, resident segment
+     * @param sequence Record sequence
+     * @param proof Output proof
+     * @return False if the record is not in a resident sealed segment
+     */
+    bool getProof(uint64 sequence, LogProof& proof) const;
+
+    /**
+     * Check a record against the root of its (possibly archived) segment
+     * @param record Record as previously read
+     * @param proof Proof from getProof()
+     * @return True if the record is committed in the log
+     */
+    bool verifyProof(const LogRecord& record, const LogProof& proof) const;
+
+    /**
+     * Get compacted segments, oldest first
+     */
+    const std::vector<LogArchive>& getArchives() const;
+
+    /**
+     * Digest used for subjects and Merkle nodes
+     */
+    static Hash256 digest(const std::string& data);
+
+    /**
+     * Log counters
+     */
+    struct Stats {
+        uint64 appended;
+        uint64 residentRecords;
+        uint64 sealedSegments;     // Resident, excluding the active segment
+        uint64 archivedSegments;
+        uint64 archivedRecords;
+        uint64 internedNames;      // Referenced by resident records
+    };
+
+    /**
+     * Get log statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Segment {
+        uint64 firstSequence;
+        std::vector<LogRecord> records;
+        Hash256 merkleRoot;  // Set when sealed
+    };
+
+    uint32 segmentRecords;
+    uint32 retainedSegments;
+    uint64 nextSequence;
+    std::deque<Segment> segments;  // Sealed segments, then the active one
+    std::vector<LogArchive> archives;
+    std::vector<std::string> names;
+    std::vector<uint32> nameRefs;   // Resident records using each name
+    std::vector<uint32> freeNames;  // Released IDs, reused first
+    std::unordered_map<std::string, uint32> nameIds;
+    uint64 nameBytes;  // Heap held by interned strings, both copies
+
+    friend uint64 heapBytes(const SegmentedLog& log);
+
+    // Helper methods
+    uint32 intern(const std::string& name);
+    void release(uint32 id);
+    void seal(Segment& segment);
+    void compact();
+    const Segment* findSegment(uint64 sequence) const;
+    bool rootOf(uint64 sequence, Hash256& root, uint32& count) const;
+};
+
+/**
+ * Approximate bytes held by a log (resident records, archives, names)
+ * O(resident segments): never walks records or names
+ */
+uint64 heapBytes(const SegmentedLog& log);
+
+}  // namespace UCIC
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "types.h"
+#include <string>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// SIGNATURE SCHEME
+// ============================================================================
+
+/**
+ * Schnorr signatures over the order-q subgroup of Z_p*, p = 2q + 1.
+ *
+ * The 63-bit safe prime keeps every group operation inside a single
+ * 128-bit multiply. Like the simplified BLAKE3 in the Oracle contract,
+ * the parameters are sized for simulation, not for production security.
+ */
+constexpr uint64 SIGNATURE_GROUP_P = 0x7FFFFFFFFFFFEE27ULL;  // Safe prime
+constexpr uint64 SIGNATURE_GROUP_Q = 0x3FFFFFFFFFFFF713ULL;  // (p - 1) / 2
+constexpr uint64 SIGNATURE_GROUP_G = 4;                      // Generator of order q
+
+// Transactions verified together in one multi-scalar check
+constexpr uint32 SIGNATURE_BATCH_SIZE = 64;
+
+/**
+ * Canonical encoding of a transaction (everything except the signature)
+ * Fixed-width little-endian integers, length-prefixed strings
+ * @param tx Transaction to encode
+ * @return Byte string covered by the signature
+ */
+std::string encodeTransaction(const SignedTransaction& tx);
+
+/**
+ * Check that a public key is an element of the order-q subgroup
+ * Keys are validated once when bound to an account, not per signature
+ * @param key Public key to check
+ * @return True if the key is usable for verification
+ */
+bool isValidPublicKey(SignerKey key);
+
+/**
+ * Derive the public key for a secret key
+ * @param secretKey Secret scalar (reduced mod q, must be non-zero)
+ * @return Public key g^x mod p, or 0 if the secret is invalid
+ */
+SignerKey derivePublicKey(uint64 secretKey);
+
+/**
+ * Sign a transaction with a deterministic nonce
+ * @param tx Transaction to sign (senderKey must match secretKey)
+ * @param secretKey Sender's secret scalar
+ * @return Signature over encodeTransaction(tx)
+ */
+Signature signTransaction(const SignedTransaction& tx, uint64 secretKey);
+
+/**
+ * Verify a single transaction signature
+ * Cofactored check (g^s == +/-R*y^e), consistent with BatchVerifier
+ * @param tx Transaction to verify
+ * @return True if the signature is valid for tx.senderKey
+ */
+bool verifyTransaction(const SignedTransaction& tx);
+
+// ============================================================================
+// BATCH VERIFIER
+// ============================================================================
+
+/**
+ * Batch Signature Verifier
+ *
+ * Verifies many signatures at once by checking a random linear
+ * combination of the verification equations:
+ *   g^(-sum z_i*s_i) * prod R_i^z_i * y_i^(z_i*e_i) == +/-1
+ * evaluated with one interleaved multi-exponentiation per batch.
+ * Failing batches are bisected so only the invalid entries are rejected.
+ * Batches are spread over worker threads.
+ */
+class BatchVerifier {
+public:
+    /**
+     * Throughput counters (cumulative)
+     */
+    struct Stats {
+        uint64 verified;
+        uint64 rejected;
+        uint64 batches;
+        uint64 elapsedNanos;
+
+        /**
+         * Get verification throughput
+         * @return Signatures checked per second
+         */
+        double throughput() const;
+    };
+
+    /**
+     * @param workers Worker threads (0 = hardware concurrency)
+     * @param batchSize Signatures per multi-scalar check
+     */
+    explicit BatchVerifier(uint32 workers = 0, uint32 batchSize = SIGNATURE_BATCH_SIZE);
+
+    /**
+     * Verify a set of transactions
+     * @param txs Transactions to verify
+     * @return Per-transaction validity, same order as txs
+     */
+    std::vector<bool> verifyBatch(const std::vector<SignedTransaction>& txs);
+
+    /**
+     * Get cumulative verification statistics
+     */
+    Stats getStats() const;
+
+private:
+    uint32 workers;
+    uint32 batchSize;
+    Stats stats;
+
+    // Helper methods
+    void verifyRange(const std::vector<SignedTransaction>& txs,
+                     size_t begin, size_t end, uint8* results, uint64 seed) const;
+};
+
+}  // namespace UCIC
@@ -2,9 +2,17 @@
 
 #include "types.h"
 #include "UCTokenContract.h"
+#include "VersionedMap.h"
+#include "ColumnarExport.h"
+#include "EpochStats.h"
+#include "MemoryUsage.h"
+#include "SegmentedLog.h"
+#include <array>
+#include <functional>
 #include <map>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 namespace UCIC {
 
@@ -15,9 +23,11 @@ namespace UCIC {
  * Features:
  *  - 5-tier contributor recognition system
  *  - Composite scoring based on multiple evaluation criteria
- *  - Democratic voting with tier-based voting power
- *  - Monthly reward distribution
+ *  - Democratic voting with tier-based voting power, snapshotted per proposal
+ *  - Monthly reward distribution with lazily accrued per-tier rewards
  *  - Governance proposals
+ *  - Versioned state: reporting queries read a pinned snapshot and never
+ *    block operations (which must be serialized, as BlockExecutor does)
  */
 class UCICDaoContract {
 public:
@@ -25,7 +35,14 @@ public:
     // CONSTRUCTOR & LIFECYCLE
     // ========================================================================
     
-    UCICDaoContract(std::shared_ptr<UCTokenContract> tokenContract);
+    // Source of the current time, in seconds since the epoch
+    using Clock = std::function<Timestamp()>;
+    
+    /**
+     * @param tokenContract Token contract (rewards, signed vote authorization)
+     * @param clock Contract clock for deadlines and timestamps (null = system clock)
+     */
+    explicit UCICDaoContract(std::shared_ptr<UCTokenContract> tokenContract, Clock clock = nullptr);
     ~UCICDaoContract() = default;
     
     // ========================================================================
@@ -77,7 +94,8 @@ public:
     
     /**
      * Calculate composite score from individual categories
-     * Formula: (Code*0.25 + Docs*0.20 + Testing*0.20 + Innovation*0.20 + Community*0.15)
+     * Uses the current scoring weights; by default
+     * (Code*0.25 + Docs*0.20 + Testing*0.20 + Innovation*0.20 + Community*0.15)
      * @param codeQuality Code quality score (0-100)
      * @param documentation Documentation quality (0-100)
      * @param testing Test coverage and quality (0-100)
@@ -89,6 +107,22 @@ public:
                                   uint8 testing, uint8 innovation, 
                                   uint8 community) const;
     
+    /**
+     * Get the scoring weights in effect
+     * @return Current weights (defaults until changed by a proposal)
+     */
+    const ScoringWeights& getScoringWeights() const;
+    
+    /**
+     * Recompute every composite score and tier from the stored category scores
+     * One vectorized sweep over the score table; only contributors whose
+     * score changed are written back. Voting power changes share one new
+     * snapshot, and the tier counts and leaderboard index are rebuilt.
+     * Called when a weights proposal is executed.
+     * @return Number of contributors whose composite score changed
+     */
+    uint64 rescoreAll();
+    
     /**
      * Get contributor's current composite score
      * @param address Contributor address
@@ -112,6 +146,7 @@ public:
     
     /**
      * Get contributors at specific tier
+     * Reads the latest snapshot
      * @param tier Tier to query
      * @return Vector of addresses in that tier
      */
@@ -123,7 +158,9 @@ public:
     
     /**
      * Distribute monthly rewards
-     * Called once per month to distribute rewards based on tier
+     * Called once per month; credits each tier's share to its cumulative
+     * reward-per-member accumulator in O(tiers). Members collect their
+     * share with claimRewards().
      * @param timestamp Current timestamp for this reward cycle
      * @return Number of contributors rewarded
      */
@@ -131,6 +168,7 @@ public:
     
     /**
      * Get pending reward for contributor
+     * Exact amount accrued since the last claim, in O(1)
      * @param address Contributor address
      * @return Pending reward amount in smallest units
      */
@@ -138,6 +176,7 @@ public:
     
     /**
      * Claim available rewards
+     * Pays the pending reward out of the treasury
      * @param contributor Address claiming rewards
      * @return Amount of rewards claimed
      */
@@ -155,6 +194,8 @@ public:
     
     /**
      * Create new governance proposal
+     * Voting power is snapshotted at creation; later tier changes do not
+     * affect this proposal's tally
      * @param proposer Address proposing change
      * @param title Proposal title
      * @param description Detailed description
@@ -164,9 +205,33 @@ public:
                          const std::string& title,
                          const std::string& description);
     
+    /**
+     * Create a proposal that replaces the scoring weights when executed
+     * @param proposer Address proposing change
+     * @param title Proposal title
+     * @param description Detailed description
+     * @param weights New weights, must add up to ScoringWeights::TOTAL_WEIGHT
+     * @return Proposal ID, 0 if the proposer or the weights are invalid
+     */
+    uint32 createWeightsProposal(const PublicAddress& proposer,
+                                 const std::string& title,
+                                 const std::string& description,
+                                 const ScoringWeights& weights);
+    
+    /**
+     * Close voting on a proposal whose deadline has passed
+     * Passes if at least MIN_VOTING_THRESHOLD_PERCENT of the snapshot voting
+     * power was cast and votes for outweigh votes against
+     * @param proposalId Proposal to finalize, at or after its voting deadline
+     * @return True if the proposal passed
+     */
+    bool finalizeProposal(uint32 proposalId);
+    
     /**
      * Cast vote on a proposal
-     * Voting power depends on contributor tier
+     * Voting power is the voter's power at the proposal snapshot;
+     * contributors registered after the snapshot cannot vote, and votes
+     * are rejected once the deadline has passed or the proposal is finalized
      * @param proposalId Proposal to vote on
      * @param voter Address of voter
      * @param voteType FOR, AGAINST, or ABSTAIN
@@ -177,6 +242,7 @@ public:
     /**
      * Execute a passed proposal
      * Only callable after voting period expires and proposal passes
+     * (see finalizeProposal()); a weights proposal rescores everyone
      * @param proposalId Proposal to execute
      * @return Success status
      */
@@ -196,6 +262,29 @@ public:
      */
     uint64 getVotingPower(const PublicAddress& address) const;
     
+    /**
+     * Get historical voting power of contributor
+     * O(log n) lookup in the contributor's checkpoint history
+     * @param address Contributor address
+     * @param snapshotId Snapshot to query (see Proposal::snapshotId)
+     * @return Voting power in effect at that snapshot, 0 if not yet registered
+     */
+    uint64 getVotingPowerAt(const PublicAddress& address, uint64 snapshotId) const;
+    
+    /**
+     * Get total voting power of all contributors at a snapshot
+     * @param snapshotId Snapshot to query
+     * @return Total voting power in effect at that snapshot
+     */
+    uint64 getTotalVotingPowerAt(uint64 snapshotId) const;
+    
+    /**
+     * Get the current snapshot ID
+     * Advances whenever any contributor's voting power changes
+     * @return Latest snapshot ID
+     */
+    uint64 getCurrentSnapshot() const;
+    
     /**
      * Check if contributor has voted on proposal
      * @param proposalId Proposal to check
@@ -206,6 +295,7 @@ public:
     
     /**
      * Get active proposals
+     * Reads the latest snapshot
      * @return Vector of active proposal IDs
      */
     std::vector<uint32> getActiveProposals() const;
@@ -237,7 +327,7 @@ public:
     
     /**
      * Get contributor audit trail
-     * All scoring updates and transactions
+     * All scoring updates and transactions, read from the latest snapshot
      * @param address Contributor address
      * @return Vector of transaction hashes
      */
@@ -253,6 +343,18 @@ public:
                                const PublicAddress& actor,
                                const TransactionHash& txHash);
     
+    /**
+     * Get the governance log
+     * Recent records are resident; older segments are archived as Merkle roots
+     */
+    const SegmentedLog& getGovernanceLog() const;
+    
+    /**
+     * Set how many sealed governance log segments stay resident
+     * @param retainedSegments Sealed segments kept before compaction
+     */
+    void setLogRetention(uint32 retainedSegments);
+    
     /**
      * Verify DAO integrity
      * Check all data consistency
@@ -260,6 +362,16 @@ public:
      */
     bool verifyIntegrity() const;
     
+    /**
+     * Report entry counts and approximate bytes per internal structure
+     * Versions pinned only by outstanding snapshots are not counted, and
+     * audit trails are counted by length. Reads counters kept by the
+     * writers, so it is O(1) regardless of the number of contributors.
+     * Must run on the thread that mutates the contract
+     * @return Memory report (contract "dao")
+     */
+    MemoryUsage getMemoryUsage() const;
+    
     // ========================================================================
     // STATISTICS & REPORTING
     // ========================================================================
@@ -279,12 +391,16 @@ public:
     
     /**
      * Get current DAO statistics
+     * Computed from one snapshot, so all fields are mutually consistent;
+     * reads running totals, O(log p) in the open proposals
      * @return Statistics structure
      */
     Statistics getStatistics() const;
     
     /**
      * Get top contributors by score
+     * Reads the latest snapshot; served from the leaderboard index while no
+     * score changed since the last rescoreAll(), otherwise sorted in O(n log n)
      * @param limit Maximum number of results
      * @return Vector of contributor addresses sorted by score
      */
@@ -292,26 +408,163 @@ public:
     
     /**
      * Get tier distribution
+     * Reads the member counts of the latest snapshot; O(tiers)
      * @return Map of tier to contributor count
      */
     std::map<ContributorTier, uint64> getTierDistribution() const;
+    
+    /**
+     * Governance activity aggregated over one epoch, or merged over a window
+     */
+    struct EpochStats {
+        uint64 newContributors;
+        uint64 proposals;
+        uint64 executedProposals;
+        uint64 votes;
+        uint64 votingPowerCast;
+        uint64 rewardsDistributed;  // Units credited to the reward pools
+        uint64 rewardsClaimed;      // Units paid out by claimRewards()
+        
+        EpochStats() 
+            : newContributors(0), proposals(0), executedProposals(0), votes(0),
+              votingPowerCast(0), rewardsDistributed(0), rewardsClaimed(0) {}
+        
+        void merge(const EpochStats& other) {
+            newContributors += other.newContributors;
+            proposals += other.proposals;
+            executedProposals += other.executedProposals;
+            votes += other.votes;
+            votingPowerCast += other.votingPowerCast;
+            rewardsDistributed += other.rewardsDistributed;
+            rewardsClaimed += other.rewardsClaimed;
+        }
+    };
+    
+    /**
+     * Get activity over the most recent epochs (daily), current one included
+     * Maintained incrementally; O(epochs). Unlike the snapshot queries this
+     * must run on the thread that mutates the contract.
+     * @param epochs Window length in epochs
+     * @return Merged aggregate
+     */
+    EpochStats getRollingStats(uint32 epochs) const;
+    
+    /**
+     * Consistent view of DAO state at the end of a committed operation
+     */
+    struct StateSnapshot {
+        VersionedMap<PublicAddress, Contributor>::Snapshot contributors;
+        VersionedMap<uint32, Proposal>::Snapshot proposals;
+        uint64 totalVotingPower;
+        uint64 totalRewardsDistributed;
+        Timestamp lastRewardDistribution;
+        uint64 version;  // Increments with every committed operation
+        // Top LEADERBOARD_SIZE (address, score), best first; null once a score changes
+        std::shared_ptr<const std::vector<std::pair<PublicAddress, uint32>>> leaderboard;
+        std::array<uint64, NUM_TIERS> tierMembers;
+        uint64 executedProposals;
+        std::shared_ptr<const std::vector<Timestamp>> openDeadlines;  // PENDING/ACTIVE proposals, sorted
+    };
+    
+    /**
+     * Pin the latest committed state
+     * O(1); the snapshot can be read on any thread without blocking writers
+     * and stays valid until released
+     * @return Immutable snapshot
+     */
+    std::shared_ptr<const StateSnapshot> getSnapshot() const;
+    
+    /**
+     * Export DAO state in columnar form
+     * Tables: contributors and proposals, from one snapshot, sorted by key.
+     * Safe to call on any thread.
+     * @param writer Destination writer
+     */
+    void exportColumnar(ColumnarWriter& writer) const;
 
 private:
+    // Signed votes are applied by the block pipeline once verified
+    friend class BlockExecutor;
+    
+    /**
+     * Apply a signed DAO operation (CAST_VOTE) whose signature has
+     * already been verified
+     * The sender must be authorized by the token contract (bound key,
+     * next nonce); the nonce is consumed only if the vote is recorded
+     * @param tx Verified transaction envelope
+     * @return Success status
+     */
+    bool applyVerifiedTransaction(const SignedTransaction& tx);
+    
     std::shared_ptr<UCTokenContract> tokenContract;
+    Clock clock;
     
     // Core data structures
-    std::map<PublicAddress, Contributor> contributors;
-    std::map<uint32, Proposal> proposals;
+    VersionedMap<PublicAddress, Contributor> contributors;
+    VersionedMap<uint32, Proposal> proposals;
+    uint64 executedProposals;
+    std::shared_ptr<const std::vector<Timestamp>> openDeadlines;  // Shared with the snapshots until one opens or closes
     std::map<std::pair<uint32, PublicAddress>, Vote> votes;
-    std::vector<TransactionHash> governanceLog;
+    SegmentedLog governanceLog;
     
     uint32 nextProposalId;
     uint64 totalRewardsDistributed;
     Timestamp lastRewardDistribution;
+    EpochSeries<EpochStats> epochStats;
+    
+    // Latest committed version, read by the reporting queries
+    mutable std::mutex snapshotMutex;
+    std::shared_ptr<const StateSnapshot> published;
+    uint64 stateVersion;
+    
+    // Voting power checkpoints
+    uint64 snapshotClock;
+    uint64 totalVotingPower;
+    std::map<PublicAddress, std::vector<VotingCheckpoint>> votingPowerHistory;
+    std::vector<VotingCheckpoint> totalVotingPowerHistory;
+    
+    // Lazy reward accounting, indexed by tier
+    std::array<uint64, NUM_TIERS> rewardPerMember;  // Cumulative units per member
+    std::array<uint64, NUM_TIERS> rewardCarry;      // Indivisible remainder for next cycle
+    std::array<uint64, NUM_TIERS> tierMembers;
+    
+    // Latest category scores, one row per contributor (structure of arrays)
+    struct ScoreTable {
+        std::array<std::vector<uint8>, NUM_SCORE_CATEGORIES> categories;
+        std::vector<uint32> bonusPoints;      // Module bonuses since the last submission
+        std::vector<uint32> compositeScores;  // Mirrors Contributor::compositeScore
+        std::vector<uint8> tiers;             // Mirrors Contributor::tier
+        std::vector<PublicAddress> addresses;
+    };
+    
+    // Scoring
+    ScoringWeights scoringWeights;
+    std::map<uint32, ScoringWeights> weightProposals;  // Pending, by proposal ID
+    ScoreTable scoreTable;
+    std::shared_ptr<const std::vector<std::pair<PublicAddress, uint32>>> leaderboard;
+    
+    // Memory accounting, kept current by the writers (see getMemoryUsage())
+    StructureCounter contributorUsage;
+    StructureCounter proposalUsage;
+    StructureCounter voteUsage;
+    StructureCounter scoreUsage;
+    StructureCounter checkpointUsage;
+    uint64 leaderboardBytes;
     
     // Helper methods
+    void publishSnapshot();
     void updateTier(const PublicAddress& address);
+    void setCompositeScore(Contributor& contrib, uint32 score);
+    void rebuildLeaderboard();
+    void settleRewards(Contributor& contrib) const;
+    void recordVotingPower(const PublicAddress& address, uint64 oldPower, uint64 newPower);
+    void appendCheckpoint(const PublicAddress& address, uint64 snapshot, uint64 votingPower);
+    void appendAuditTrail(Contributor& contrib, const TransactionHash& txHash);
     bool validateProposal(const Proposal& proposal) const;
+    Timestamp currentTime() const;
+    bool isVotingOpen(const Proposal& proposal) const;
+    static std::map<ContributorTier, uint64> getTierDistribution(const StateSnapshot& snapshot);
+    void setVotingOpen(Timestamp votingDeadline, bool open);
     uint64 calculateRewardAmount(ContributorTier tier) const;
 };
 
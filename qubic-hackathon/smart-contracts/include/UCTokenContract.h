@@ -1,11 +1,23 @@
 #pragma once
 
 #include "types.h"
+#include "TransactionAuth.h"
+#include "ColumnarExport.h"
+#include "EpochStats.h"
+#include "MemoryUsage.h"
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 
 namespace UCIC {
 
+class ReplicationLog;
+class BlockExecutor;
+class UCICDaoContract;
+
 /**
  * UC Token Contract
  * 
@@ -13,9 +25,11 @@ namespace UCIC {
  * Total supply: 1,000 UC (with 8 decimal places)
  * Features:
  *  - Transfer functionality with balance tracking
+ *  - Signed transaction envelopes with nonce-based replay protection
  *  - Mint/Burn for governance
  *  - Treasury management
  *  - Access control for sensitive operations
+ *  - Write-ahead log of committed state for read-only replicas
  */
 class UCTokenContract {
 public:
@@ -23,9 +37,18 @@ public:
     // CONSTRUCTOR & LIFECYCLE
     // ========================================================================
     
-    UCTokenContract();
+    /**
+     * @param treasuryKey Public key bound to the treasury account; treasury
+     *                    payouts are TRANSFER envelopes signed with it
+     *                    (0 = payouts only through distributeReward/treasuryWithdraw)
+     */
+    explicit UCTokenContract(SignerKey treasuryKey = 0);
     ~UCTokenContract() = default;
     
+    // accountsById holds raw pointers into accounts: a copy would point into this ledger
+    UCTokenContract(const UCTokenContract&) = delete;
+    UCTokenContract& operator=(const UCTokenContract&) = delete;
+    
     // ========================================================================
     // TOKEN INFORMATION
     // ========================================================================
@@ -55,6 +78,11 @@ public:
      */
     uint64 getTreasuryBalance() const;
     
+    /**
+     * Get treasury account address (sender of signed treasury payouts)
+     */
+    const PublicAddress& getTreasuryAddress() const;
+    
     // ========================================================================
     // BALANCE QUERIES
     // ========================================================================
@@ -75,49 +103,56 @@ public:
     uint64 allowance(const PublicAddress& owner, const PublicAddress& spender) const;
     
     // ========================================================================
-    // TRANSFER OPERATIONS
+    // AUTHENTICATED TRANSACTIONS
     // ========================================================================
     
     /**
-     * Transfer tokens from sender to recipient
-     * @param recipient Target address
-     * @param amount Amount in smallest units
+     * Create an account bound to a signing key
+     * Keys are only bound at creation: an existing account, funded or
+     * not, cannot be claimed by binding a key to it
+     * @param account Address to create
+     * @param publicKey Public key (see derivePublicKey())
      * @return Success status
      */
-    bool transfer(const PublicAddress& recipient, uint64 amount);
+    bool bindAccountKey(const PublicAddress& account, SignerKey publicKey);
     
     /**
-     * Transfer tokens on behalf of owner (requires approval)
-     * @param owner Token owner address
-     * @param recipient Target address
-     * @param amount Amount in smallest units
+     * Verify and apply a single signed transaction
+     * Requires a valid signature by the sender's bound key and
+     * tx.nonce equal to the sender's current nonce
+     * @param tx Signed transaction envelope
      * @return Success status
      */
-    bool transferFrom(const PublicAddress& owner, const PublicAddress& recipient, uint64 amount);
+    bool submitTransaction(const SignedTransaction& tx);
     
     /**
-     * Approve spender to use tokens on behalf of sender
-     * @param spender Address to approve
-     * @param amount Amount to approve in smallest units
-     * @return Success status
+     * Verify a set of signed transactions in batches, then apply the
+     * valid ones in order
+     * @param txs Signed transaction envelopes
+     * @return Per-transaction success, same order as txs
      */
-    bool approve(const PublicAddress& spender, uint64 amount);
+    std::vector<bool> submitTransactionBatch(const std::vector<SignedTransaction>& txs);
     
     /**
-     * Increase approved allowance
-     * @param spender Address to increase allowance for
-     * @param addedValue Amount to add to allowance
-     * @return Success status
+     * Get the next expected nonce of an account
+     * @param account Address to query
+     * @return Nonce, 0 for unknown accounts
      */
-    bool increaseAllowance(const PublicAddress& spender, uint64 addedValue);
+    uint64 getNonce(const PublicAddress& account) const;
     
     /**
-     * Decrease approved allowance
-     * @param spender Address to decrease allowance for
-     * @param subtractedValue Amount to subtract from allowance
-     * @return Success status
+     * Get the key bound to an account
+     * Safe to call from any thread (e.g. Mempool::add): keys never change once bound
+     * @param account Address to query
+     * @return Bound public key, 0 if none
      */
-    bool decreaseAllowance(const PublicAddress& spender, uint64 subtractedValue);
+    SignerKey getBoundKey(const PublicAddress& account) const;
+    
+    /**
+     * Get signature verification throughput counters
+     * @return Cumulative batch verifier statistics
+     */
+    BatchVerifier::Stats getVerificationStats() const;
     
     // ========================================================================
     // MINTING & BURNING (GOVERNANCE ONLY)
@@ -237,31 +272,174 @@ public:
      */
     State getContractState() const;
     
+    /**
+     * Ledger activity aggregated over one epoch, or merged over a window
+     */
+    struct EpochStats {
+        uint64 transfers;    // Movements between accounts, fees included
+        uint64 volume;       // Units moved by those transfers
+        uint64 minted;
+        uint64 burned;
+        uint64 newAccounts;
+        
+        EpochStats() : transfers(0), volume(0), minted(0), burned(0), newAccounts(0) {}
+        
+        void merge(const EpochStats& other) {
+            transfers += other.transfers;
+            volume += other.volume;
+            minted += other.minted;
+            burned += other.burned;
+            newAccounts += other.newAccounts;
+        }
+    };
+    
+    /**
+     * Get activity over the most recent epochs (daily), current one included
+     * Maintained incrementally; O(epochs)
+     * @param epochs Window length in epochs
+     * @return Merged aggregate
+     */
+    EpochStats getRollingStats(uint32 epochs) const;
+    
     /**
      * Verify contract integrity
      * Ensures balances sum correctly
      * @return True if state is consistent
      */
     bool verifyIntegrity() const;
+    
+    /**
+     * Report entry counts and approximate bytes per internal structure
+     * Reads counters kept by the writers: O(1) regardless of ledger size
+     * Must run on the thread that mutates the contract
+     * @return Memory report (contract "token")
+     */
+    MemoryUsage getMemoryUsage() const;
+    
+    /**
+     * Export ledger state in columnar form
+     * Tables: accounts (one row per account) and transactions (one row per
+     * history entry). Must run on the thread that mutates the contract.
+     * @param writer Destination writer
+     */
+    void exportColumnar(ColumnarWriter& writer) const;
+    
+    // ========================================================================
+    // REPLICATION
+    // ========================================================================
+    
+    /**
+     * Start capturing state changes into a replication log
+     * @param log Log receiving commit groups (nullptr stops capturing)
+     */
+    void attachReplicationLog(std::shared_ptr<ReplicationLog> log);
+    
+    /**
+     * Append everything changed since the last commit as one commit group
+     * BlockExecutor commits after each block; WalShipper before shipping
+     * @return Sequence of the latest commit group, 0 if no log is attached
+     */
+    uint64 commitReplication();
+    
+    /**
+     * Export the full ledger as records for bootstrapping a replica
+     * Taken right after commitReplication() it matches that commit group
+     * @return BOOTSTRAP record followed by the state image (no COMMIT)
+     */
+    std::vector<WalRecord> exportReplicationImage() const;
+    
+    /**
+     * Apply a shipped record to this contract (replicas only)
+     * @param record Record from the primary's log
+     * @return False if the record type is not a state record
+     */
+    bool applyReplicationRecord(const WalRecord& record);
 
 private:
+    // The verified path: only callers that checked the signature apply envelopes
+    friend class BlockExecutor;
+    friend class UCICDaoContract;
+    
+    /**
+     * Apply a token operation (TRANSFER, APPROVE or TRANSFER_FROM) whose
+     * signature has already been verified
+     * APPROVE changes the sender's own allowances; TRANSFER_FROM spends
+     * an allowance tx.owner granted to the sender
+     * @param tx Verified transaction envelope
+     * @return Success status
+     */
+    bool applyVerifiedTransaction(const SignedTransaction& tx);
+    
+    /**
+     * Check that the sender's bound key signed tx, tx.nonce is the
+     * sender's next nonce and the fee is affordable
+     * Does not verify the signature itself
+     * @param tx Transaction envelope
+     * @return True if tx may be executed now
+     */
+    bool isAuthorized(const SignedTransaction& tx) const;
+    
+    /**
+     * Collect the fee into the treasury and consume the sender's nonce
+     * Called once an authorized operation has been applied
+     * @param tx Transaction envelope
+     * @return Success status
+     */
+    bool settleTransaction(const SignedTransaction& tx);
+    
+    // Allowances granted by one owner, sorted by spender ID
+    using AllowanceTable = std::vector<std::pair<AccountId, uint64>>;
+    
     // Core data structures
-    std::map<PublicAddress, Account> accounts;
-    std::map<std::pair<PublicAddress, PublicAddress>, uint64> allowances;
-    std::map<PublicAddress, std::vector<TransactionHash>> transactionHistories;
+    std::unordered_map<PublicAddress, Account> accounts;
+    std::vector<const Account*> accountsById;      // Indexed by Account::id
+    std::deque<AllowanceTable> allowanceTables;    // Indexed by owner ID; stable references
+    std::vector<TransferRecord> transfers;         // Ledger in commit order
+    std::map<PublicAddress, std::vector<uint64>> transactionHistories;  // Indices into transfers
     
     uint64 totalSupply;
     uint64 treasuryBalance;
     uint64 transactionCount;
+    EpochSeries<EpochStats> epochStats;
     
     // Access control
     std::set<PublicAddress> governors;
     PublicAddress treasuryAddress;
     
+    // Signature verification
+    BatchVerifier verifier;
+    mutable std::mutex keysMutex;
+    std::unordered_map<PublicAddress, SignerKey> boundKeys;  // Copy of Account::publicKey for other threads
+    
+    // Changes not yet committed to the replication log
+    std::shared_ptr<ReplicationLog> replicationLog;
+    std::set<PublicAddress> dirtyAccounts;
+    std::set<std::pair<PublicAddress, PublicAddress>> dirtyAllowances;
+    std::vector<WalRecord> pendingHistory;
+    
+    // Memory accounting, kept current by the writers (see getMemoryUsage())
+    StructureCounter accountUsage;
+    StructureCounter allowanceUsage;
+    StructureCounter transferUsage;
+    StructureCounter historyUsage;
+    StructureCounter pendingUsage;  // Replication changes not yet committed
+    
     // Helper methods
     bool validateAmount(uint64 amount) const;
     bool validateAddress(const PublicAddress& addr) const;
     void updateBalance(const PublicAddress& account, int64 delta);
+    Account& ensureAccount(const PublicAddress& account);
+    Account& writableAccount(const PublicAddress& account);
+    void markAccount(const PublicAddress& account);
+    void setBoundKey(Account& account, SignerKey publicKey);
+    AllowanceTable::iterator findAllowance(AllowanceTable& table, AccountId spender);
+    bool hasAllowance(const AllowanceTable& table, AllowanceTable::const_iterator slot, AccountId spender) const;
+    void setAllowance(const Account& owner, const Account& spender, uint64 amount);
+    void storeAllowance(const Account& owner, const Account& spender, AllowanceTable::iterator slot, uint64 amount);
+    void markAllowance(const Account& owner, const Account& spender);
+    void appendTransfer(const TransferRecord& transfer);
+    bool changeAllowance(const SignedTransaction& tx);
+    bool spendAllowance(const SignedTransaction& tx);
 };
 
 }  // namespace UCIC
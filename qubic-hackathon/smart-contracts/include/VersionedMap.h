@@ -0,0 +1,295 @@
+#pragma once
+
+#include "types.h"
+#include "MemoryUsage.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace UCIC {
+
+// ============================================================================
+// VERSIONED MAP
+// ============================================================================
+
+/**
+ * Versioned Map
+ *
+ * Copy-on-write hash array mapped trie. Inner nodes consume
+ * VERSIONED_MAP_BITS of the hash and hold only their occupied slots;
+ * leaves split once they exceed VERSIONED_MAP_LEAF_CAPACITY entries, so
+ * the trie deepens as the map grows. snapshot() pins the current version
+ * in O(1); the next write to a pinned path copies the root, O(log n)
+ * inner nodes and one bounded leaf, so writers never wait for readers
+ * and readers iterate a consistent version without locks. A version is
+ * freed when its last snapshot is released.
+ *
+ * Writes must come from one thread at a time. Snapshots may be read and
+ * released on any thread.
+ */
+constexpr int VERSIONED_MAP_BITS = 6;                  // 64-way inner nodes
+constexpr size_t VERSIONED_MAP_LEAF_CAPACITY = 8;      // Entries before a leaf splits
+constexpr int VERSIONED_MAP_MAX_DEPTH =                // Deepest inner node; leaves below grow
+    static_cast<int>(sizeof(size_t) * 8 - 1) / VERSIONED_MAP_BITS;
+
+template <typename K, typename V, typename Hash = std::hash<K>>
+class VersionedMap {
+private:
+    struct Node {
+        bool leaf = true;
+        uint64 bitmap = 0;                             // Inner: occupied slots
+        std::vector<std::shared_ptr<Node>> children;   // Inner: one per set bit, slot order
+        std::vector<std::pair<K, V>> entries;          // Leaf
+
+        const Node* child(size_t slot) const {
+            if (!((bitmap >> slot) & 1)) {
+                return nullptr;
+            }
+            return children[rank(slot)].get();
+        }
+
+        // Creates an empty slot if needed
+        std::shared_ptr<Node>& childSlot(size_t slot) {
+            if (!((bitmap >> slot) & 1)) {
+                bitmap |= 1ULL << slot;
+                children.insert(children.begin() + rank(slot), nullptr);
+            }
+            return children[rank(slot)];
+        }
+
+        size_t rank(size_t slot) const {
+            return static_cast<size_t>(__builtin_popcountll(bitmap & ((1ULL << slot) - 1)));
+        }
+    };
+
+    struct Root {
+        std::shared_ptr<Node> top;
+        size_t size = 0;
+        uint64 bytes = SHARED_BLOCK_OVERHEAD + sizeof(Root);  // See nodeBytes()
+    };
+
+public:
+    /**
+     * Immutable view of one version of the map
+     */
+    class Snapshot {
+    public:
+        Snapshot() = default;
+
+        /**
+         * Look up a key in this version
+         * @param key Key to find
+         * @return Pointer to the value, nullptr if absent
+         */
+        const V* find(const K& key) const {
+            return root ? lookup(*root, key) : nullptr;
+        }
+
+        /**
+         * Get number of entries in this version
+         */
+        size_t size() const {
+            return root ? root->size : 0;
+        }
+
+        /**
+         * Visit every entry (hash order)
+         * @param fn Callback taking (const K&, const V&)
+         */
+        template <typename Fn>
+        void forEach(Fn fn) const {
+            if (root) {
+                visit(*root, fn);
+            }
+        }
+
+    private:
+        friend class VersionedMap;
+        explicit Snapshot(std::shared_ptr<const Root> root) : root(std::move(root)) {}
+
+        std::shared_ptr<const Root> root;
+    };
+
+    VersionedMap() : root(std::make_shared<Root>()) {}
+
+    /**
+     * Look up a key in the current version
+     * @param key Key to find
+     * @return Pointer to the value, nullptr if absent
+     */
+    const V* find(const K& key) const {
+        return lookup(*root, key);
+    }
+
+    /**
+     * Get a writable value, copying any path shared with a snapshot
+     * @param key Key to modify
+     * @return Pointer to the value, nullptr if absent
+     */
+    V* mutate(const K& key) {
+        if (!find(key)) {
+            return nullptr;
+        }
+        Node& leaf = writableLeaf(key, false);
+        for (auto& entry : leaf.entries) {
+            if (entry.first == key) {
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Insert a new entry
+     * @param key Key to insert
+     * @param value Value to store
+     * @return True if inserted, false if the key already exists
+     */
+    bool insert(const K& key, const V& value) {
+        if (find(key)) {
+            return false;
+        }
+        Node& leaf = writableLeaf(key, true);
+        uint64 before = ownBytes(leaf);
+        leaf.entries.emplace_back(key, value);
+        root->bytes += ownBytes(leaf) - before;
+        root->size++;
+        return true;
+    }
+
+    /**
+     * Get number of entries in the current version
+     */
+    size_t size() const {
+        return root->size;
+    }
+
+    /**
+     * Visit every entry of the current version (hash order)
+     * @param fn Callback taking (const K&, const V&)
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        visit(*root, fn);
+    }
+
+    /**
+     * Approximate bytes of the trie nodes of the current version, kept
+     * current by the writer so reading it is O(1)
+     * Includes nodes shared with snapshots; entries' own heap storage
+     * (see heapBytes()) is not included
+     */
+    uint64 nodeBytes() const {
+        return root->bytes;
+    }
+
+    /**
+     * Pin the current version
+     * Called by the writer; the snapshot can then be handed to any thread
+     * @return Immutable view unaffected by later writes
+     */
+    Snapshot snapshot() const {
+        return Snapshot(root);
+    }
+
+private:
+    std::shared_ptr<Root> root;
+
+    static size_t slot(size_t hash, int depth) {
+        return (hash >> (depth * VERSIONED_MAP_BITS)) & ((1ULL << VERSIONED_MAP_BITS) - 1);
+    }
+
+    static const V* lookup(const Root& root, const K& key) {
+        size_t hash = Hash()(key);
+        const Node* node = root.top.get();
+        for (int depth = 0; node && !node->leaf; ++depth) {
+            node = node->child(slot(hash, depth));
+        }
+        if (!node) {
+            return nullptr;
+        }
+        for (const auto& entry : node->entries) {
+            if (entry.first == key) {
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Fn>
+    static void visit(const Node& node, Fn& fn) {
+        for (const auto& entry : node.entries) {
+            fn(entry.first, entry.second);
+        }
+        for (const auto& child : node.children) {
+            visit(*child, fn);
+        }
+    }
+
+    template <typename Fn>
+    static void visit(const Root& root, Fn& fn) {
+        if (root.top) {
+            visit(*root.top, fn);
+        }
+    }
+
+    static uint64 ownBytes(const Node& node) {
+        return SHARED_BLOCK_OVERHEAD + sizeof(Node) +
+               node.children.capacity() * sizeof(std::shared_ptr<Node>) +
+               node.entries.capacity() * sizeof(std::pair<K, V>);
+    }
+
+    // A node is written in place only when no other version references it
+    template <typename T>
+    static T& unshare(std::shared_ptr<T>& node) {
+        if (!node) {
+            node = std::make_shared<T>();
+        } else if (node.use_count() > 1) {
+            node = std::make_shared<T>(*node);
+        } else {
+            // Pairs with the release of the last snapshot that held the node
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *node;
+    }
+
+    // Turns a full leaf into an inner node over new leaves
+    static void split(Node& node, int depth) {
+        std::vector<std::pair<K, V>> entries;
+        entries.swap(node.entries);
+        node.leaf = false;
+        for (auto& entry : entries) {
+            Node& child = unshare(node.childSlot(slot(Hash()(entry.first), depth)));
+            child.entries.push_back(std::move(entry));
+        }
+    }
+
+    // Copies along the path replace their originals in this version, so
+    // only the difference in node size changes the root's byte count
+    Node& writableLeaf(const K& key, bool inserting) {
+        size_t hash = Hash()(key);
+        Root& current = unshare(root);
+        std::shared_ptr<Node>* link = &current.top;
+        for (int depth = 0;; ++depth) {
+            uint64 before = *link ? ownBytes(**link) : 0;
+            Node& node = unshare(*link);
+            if (node.leaf) {
+                if (!inserting || node.entries.size() < VERSIONED_MAP_LEAF_CAPACITY ||
+                    depth > VERSIONED_MAP_MAX_DEPTH) {
+                    current.bytes += ownBytes(node) - before;
+                    return node;
+                }
+                split(node, depth);
+                for (const auto& child : node.children) {
+                    current.bytes += ownBytes(*child);
+                }
+            }
+            link = &node.childSlot(slot(hash, depth));
+            current.bytes += ownBytes(node) - before;
+        }
+    }
+};
+
+}  // namespace UCIC
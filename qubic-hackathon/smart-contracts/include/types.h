@@ -25,6 +25,8 @@ using int32 = std::int32_t;
 using PublicAddress = std::string;
 using TransactionHash = std::string;
 using Timestamp = uint64;
+using SignerKey = uint64;  // Schnorr public key (element of the signing group)
+using AccountId = uint32;  // Dense per-ledger account index, assigned at registration
 
 // ============================================================================
 // TOKEN CONSTANTS
@@ -50,6 +52,9 @@ enum class ContributorTier : uint8 {
     FOUNDER = 4          // Reserved for DAO founders
 };
 
+constexpr uint8 NUM_TIERS = 5;
+constexpr uint32 LEADERBOARD_SIZE = 1000;  // Top contributors ranked by the DAO leaderboard index
+
 // Voting Power Multipliers
 constexpr uint8 VOTING_POWER[5] = {
     1,  // RECOGNIZED: 1x
@@ -139,6 +144,8 @@ constexpr uint8 ALLOCATION_OPERATIONS = 20; // 2% of supply for operational cost
 // COMPOSITE SCORING FORMULA
 // ============================================================================
 
+// Category weights; the constants are the defaults, in effect until an
+// executed governance proposal replaces them
 struct ScoringWeights {
     static constexpr uint8 CODE_QUALITY_WEIGHT = 25;
     static constexpr uint8 DOCUMENTATION_WEIGHT = 20;
@@ -146,6 +153,29 @@ struct ScoringWeights {
     static constexpr uint8 INNOVATION_WEIGHT = 20;
     static constexpr uint8 COMMUNITY_WEIGHT = 15;
     static constexpr uint8 TOTAL_WEIGHT = 100;
+    
+    std::array<uint8, NUM_SCORE_CATEGORIES> weights;  // Indexed by ScoreCategory
+    
+    ScoringWeights() 
+        : weights{{CODE_QUALITY_WEIGHT, DOCUMENTATION_WEIGHT, TESTING_WEIGHT,
+                   INNOVATION_WEIGHT, COMMUNITY_WEIGHT}} {}
+    
+    uint8 get(ScoreCategory category) const {
+        return weights[static_cast<uint8>(category)];
+    }
+    
+    // Weights must add up to TOTAL_WEIGHT so composites stay within 0-100
+    bool isValid() const {
+        uint32 total = 0;
+        for (uint8 weight : weights) {
+            total += weight;
+        }
+        return total == TOTAL_WEIGHT;
+    }
+    
+    bool operator==(const ScoringWeights& other) const {
+        return weights == other.weights;
+    }
 };
 
 // Composite Score = (CodeQuality * 0.25) + (Docs * 0.20) + (Testing * 0.20) 
@@ -157,13 +187,104 @@ struct ScoringWeights {
 
 struct Account {
     PublicAddress address;
+    AccountId id;
     uint64 balance;
     uint64 nonce;
     Timestamp createdAt;
+    SignerKey publicKey;  // 0 until a signing key is bound
     
-    Account() : balance(0), nonce(0), createdAt(0) {}
+    Account() : id(0), balance(0), nonce(0), createdAt(0), publicKey(0) {}
     Account(const PublicAddress& addr) 
-        : address(addr), balance(0), nonce(0), createdAt(0) {}
+        : address(addr), id(0), balance(0), nonce(0), createdAt(0), publicKey(0) {}
+};
+
+// One balance movement in the ledger, stored once for both parties
+struct TransferRecord {
+    TransactionHash txHash;
+    PublicAddress from;
+    PublicAddress to;
+    uint64 amount;
+    Timestamp timestamp;
+    
+    TransferRecord() : amount(0), timestamp(0) {}
+};
+
+// Operations that can be carried by a signed transaction envelope
+enum class TransactionType : uint8 {
+    TRANSFER = 0,       // target = recipient, amount = units
+    APPROVE = 1,        // target = spender, amount = units, choice = AllowanceChange
+    CAST_VOTE = 2,      // amount = proposal ID, choice = VoteType
+    TRANSFER_FROM = 3   // sender = spender, owner = account debited, target = recipient
+};
+
+// How an APPROVE envelope changes the sender's allowance to target
+enum class AllowanceChange : uint8 {
+    SET = 0,
+    INCREASE = 1,
+    DECREASE = 2
+};
+
+struct Signature {
+    uint64 r;  // Commitment R = g^k mod p
+    uint64 s;  // Response s = k + e*x mod q
+    
+    Signature() : r(0), s(0) {}
+};
+
+// Authenticated transaction envelope
+// The signature covers the canonical encoding of every field except itself
+struct SignedTransaction {
+    TransactionType type;
+    PublicAddress sender;
+    SignerKey senderKey;
+    uint64 nonce;
+    PublicAddress target;
+    PublicAddress owner;  // TRANSFER_FROM: account whose allowance is spent
+    uint64 amount;
+    uint64 fee;      // Priority fee paid to the treasury on execution
+    uint8 choice;    // Operation-specific selector
+    Signature signature;
+    
+    SignedTransaction() 
+        : type(TransactionType::TRANSFER), senderKey(0), nonce(0), amount(0),
+          fee(0), choice(0) {}
+};
+
+// Write-ahead log record shipped from a primary ledger to its replicas
+// Records carry after-images, so replaying them needs no contract logic
+enum class WalRecordType : uint8 {
+    BOOTSTRAP = 0,  // Start of a full state image: the replica clears its state
+    ACCOUNT = 1,    // Account after-image
+    ALLOWANCE = 2,  // account = owner, counterparty = spender, amount = allowance
+    HISTORY = 3,    // Transfer: account = from, counterparty = to, createdAt = time
+    COUNTERS = 4,   // amount = total supply, balance = treasury, nonce = tx count
+    COMMIT = 5      // End of a commit group, amount = commit time (ns since epoch)
+};
+
+struct WalRecord {
+    WalRecordType type;
+    uint64 sequence;            // Commit group the record belongs to
+    PublicAddress account;
+    PublicAddress counterparty;
+    TransactionHash txHash;
+    uint64 amount;
+    uint64 balance;
+    uint64 nonce;
+    SignerKey publicKey;
+    Timestamp createdAt;
+    
+    WalRecord() 
+        : type(WalRecordType::COMMIT), sequence(0), amount(0), balance(0),
+          nonce(0), publicKey(0), createdAt(0) {}
+};
+
+constexpr size_t AUDIT_TRAIL_CHUNK_SIZE = 32;
+
+// Audit trail entries, newest chunk first; a chunk is never modified once
+// shared, so versions of a contributor share all but the newest chunk
+struct AuditTrailChunk {
+    std::vector<TransactionHash> entries;  // Capacity AUDIT_TRAIL_CHUNK_SIZE
+    std::shared_ptr<const AuditTrailChunk> previous;
 };
 
 struct Contributor {
@@ -174,11 +295,15 @@ struct Contributor {
     uint64 rewardsReceived;
     Timestamp joinedAt;
     Timestamp lastRewardClaimAt;
-    std::vector<TransactionHash> auditTrail;
+    uint64 rewardCheckpoint;  // Tier reward-per-member at last settlement
+    uint64 accruedRewards;    // Settled but not yet claimed
+    uint32 scoreRow;          // Row in the DAO's category score table
+    std::shared_ptr<const AuditTrailChunk> auditTrail;  // Fixed size, see AuditTrailChunk
     
     Contributor() 
         : tier(ContributorTier::RECOGNIZED), compositeScore(0), 
-          pointsEarned(0), rewardsReceived(0), joinedAt(0), lastRewardClaimAt(0) {}
+          pointsEarned(0), rewardsReceived(0), joinedAt(0), lastRewardClaimAt(0),
+          rewardCheckpoint(0), accruedRewards(0), scoreRow(0) {}
 };
 
 struct CategoryScore {
@@ -217,11 +342,24 @@ struct Proposal {
     Timestamp createdAt;
     Timestamp votingDeadline;
     Timestamp executionTime;
+    uint64 snapshotId;          // Voting power is read as of this snapshot
+    uint64 totalVotingPower;    // Eligible voting power at the snapshot
     
     Proposal() 
         : proposalId(0), status(ProposalStatus::PENDING), 
           votesFor(0), votesAgainst(0), votesAbstain(0),
-          createdAt(0), votingDeadline(0), executionTime(0) {}
+          createdAt(0), votingDeadline(0), executionTime(0),
+          snapshotId(0), totalVotingPower(0) {}
+};
+
+// Voting power in effect from a snapshot onwards
+struct VotingCheckpoint {
+    uint64 snapshotId;
+    uint64 votingPower;
+    
+    VotingCheckpoint() : snapshotId(0), votingPower(0) {}
+    VotingCheckpoint(uint64 snapshot, uint64 power) 
+        : snapshotId(snapshot), votingPower(power) {}
 };
 
 struct Vote {
@@ -0,0 +1,285 @@
+#include "../include/ColumnarExport.h"
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <thread>
+
+namespace UCIC {
+
+namespace {
+
+const char COLUMNAR_MAGIC[8] = {'U', 'C', 'C', 'O', 'L', 'v', '1', '\n'};
+constexpr uint64 TABLE_TAG = 1;
+
+void appendLE(std::string& out, uint64 value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64 readLE(const char* data, int bytes) {
+    uint64 value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+void pad8(std::string& out) {
+    out.append((8 - out.size() % 8) % 8, '\0');
+}
+
+size_t padded(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+int valueWidth(ColumnType type) {
+    switch (type) {
+        case ColumnType::UINT8: return 1;
+        case ColumnType::UINT32: return 4;
+        case ColumnType::UINT64: return 8;
+        default: return 4;  // STRING offsets
+    }
+}
+
+bool readWord(std::istream& in, uint64& value) {
+    char buffer[8];
+    if (!in.read(buffer, 8)) {
+        return false;
+    }
+    value = readLE(buffer, 8);
+    return true;
+}
+
+bool readString(std::istream& in, std::string& value) {
+    uint64 length = 0;
+    if (!readWord(in, length) || length > (1ULL << 32)) {
+        return false;
+    }
+    std::string bytes(padded(static_cast<size_t>(length)), '\0');
+    if (!in.read(&bytes[0], static_cast<std::streamsize>(bytes.size()))) {
+        return false;
+    }
+    value = bytes.substr(0, static_cast<size_t>(length));
+    return true;
+}
+
+}  // namespace
+
+// ============================================================================
+// COLUMN ENCODER
+// ============================================================================
+
+ColumnEncoder::ColumnEncoder(ColumnType type, size_t rows) : type(type) {
+    values.reserve((rows + 1) * valueWidth(type) + 8);
+    if (type == ColumnType::STRING) {
+        appendLE(values, 0, 4);
+    }
+}
+
+void ColumnEncoder::addInteger(uint64 value) {
+    appendLE(values, value, valueWidth(type));
+}
+
+void ColumnEncoder::addText(const std::string& value) {
+    data += value;
+    appendLE(values, data.size(), 4);
+}
+
+std::string ColumnEncoder::finish() {
+    pad8(values);
+    if (type == ColumnType::STRING) {
+        pad8(data);
+        values += data;
+    }
+    return std::move(values);
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+ColumnarWriter::ColumnarWriter(std::ostream& out, uint32 workers, uint32 batchRows)
+    : out(out),
+      workers(workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency())),
+      batchRows(batchRows > 0 ? batchRows : COLUMNAR_BATCH_ROWS),
+      stats{0, 0, 0, 0} {
+    out.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    stats.bytes += sizeof(COLUMNAR_MAGIC);
+}
+
+bool ColumnarWriter::finish() {
+    writeWord(0);
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+ColumnarWriter::Stats ColumnarWriter::getStats() const {
+    return stats;
+}
+
+void ColumnarWriter::beginTable(const std::string& name,
+                                const std::vector<std::pair<std::string, ColumnType>>& schema) {
+    std::string header;
+    appendLE(header, TABLE_TAG, 8);
+    appendLE(header, name.size(), 8);
+    header += name;
+    pad8(header);
+    appendLE(header, schema.size(), 8);
+    for (const auto& column : schema) {
+        appendLE(header, static_cast<uint64>(column.second), 8);
+        appendLE(header, column.first.size(), 8);
+        header += column.first;
+        pad8(header);
+    }
+    writeBytes(header);
+    stats.tables++;
+}
+
+void ColumnarWriter::writeBatch(uint64 rows, const std::vector<std::string>& buffers) {
+    writeWord(rows);
+    for (const auto& buffer : buffers) {
+        writeWord(buffer.size());
+        writeBytes(buffer);
+    }
+}
+
+void ColumnarWriter::endTable() {
+    writeWord(0);
+}
+
+void ColumnarWriter::writeWord(uint64 value) {
+    std::string word;
+    appendLE(word, value, 8);
+    writeBytes(word);
+}
+
+void ColumnarWriter::writeBytes(const std::string& bytes) {
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    stats.bytes += bytes.size();
+}
+
+void ColumnarWriter::parallelFor(size_t count, const std::function<void(size_t)>& task) const {
+    size_t threads = std::min<size_t>(workers, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+uint64 ColumnarWriter::now() const {
+    return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+size_t ColumnarTable::columnIndex(const std::string& column) const {
+    auto it = std::find(columnNames.begin(), columnNames.end(), column);
+    return static_cast<size_t>(it - columnNames.begin());
+}
+
+bool readColumnar(std::istream& in, std::vector<ColumnarTable>& tables) {
+    char magic[8];
+    if (!in.read(magic, 8) || !std::equal(magic, magic + 8, COLUMNAR_MAGIC)) {
+        return false;
+    }
+
+    uint64 tag = 0;
+    while (readWord(in, tag) && tag == TABLE_TAG) {
+        ColumnarTable table;
+        table.rows = 0;
+
+        uint64 columns = 0;
+        if (!readString(in, table.name) || !readWord(in, columns) || columns > 4096) {
+            return false;
+        }
+        for (uint64 c = 0; c < columns; ++c) {
+            uint64 type = 0;
+            std::string name;
+            if (!readWord(in, type) || type > static_cast<uint64>(ColumnType::STRING) ||
+                !readString(in, name)) {
+                return false;
+            }
+            table.columnTypes.push_back(static_cast<ColumnType>(type));
+            table.columnNames.push_back(name);
+        }
+        table.integers.resize(columns);
+        table.strings.resize(columns);
+
+        uint64 rows = 0;
+        while (readWord(in, rows) && rows > 0) {
+            for (uint64 c = 0; c < columns; ++c) {
+                uint64 size = 0;
+                if (!readWord(in, size) || size % 8 != 0 || size > (1ULL << 34)) {
+                    return false;
+                }
+                std::string buffer(static_cast<size_t>(size), '\0');
+                if (size > 0 && !in.read(&buffer[0], static_cast<std::streamsize>(size))) {
+                    return false;
+                }
+
+                ColumnType type = table.columnTypes[c];
+                int width = valueWidth(type);
+                // rows comes from the file; bound it by the buffer before multiplying
+                if (rows > buffer.size()) {
+                    return false;
+                }
+                uint64 values = type == ColumnType::STRING ? rows + 1 : rows;
+                if (values > buffer.size() / width) {
+                    return false;
+                }
+                size_t valueBytes = padded(static_cast<size_t>(values) * width);
+
+                if (type != ColumnType::STRING) {
+                    for (uint64 r = 0; r < rows; ++r) {
+                        table.integers[c].push_back(readLE(buffer.data() + r * width, width));
+                    }
+                    continue;
+                }
+
+                const char* data = buffer.data() + valueBytes;
+                size_t dataBytes = buffer.size() - valueBytes;
+                for (uint64 r = 0; r < rows; ++r) {
+                    uint64 begin = readLE(buffer.data() + r * 4, 4);
+                    uint64 end = readLE(buffer.data() + (r + 1) * 4, 4);
+                    if (begin > end || end > dataBytes) {
+                        return false;
+                    }
+                    table.strings[c].emplace_back(data + begin, static_cast<size_t>(end - begin));
+                }
+            }
+            table.rows += rows;
+        }
+        if (!in) {
+            return false;
+        }
+        tables.push_back(std::move(table));
+    }
+
+    return static_cast<bool>(in) && tag == 0;
+}
+
+}  // namespace UCIC
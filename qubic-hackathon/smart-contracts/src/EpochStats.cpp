@@ -0,0 +1,89 @@
+#include "../include/EpochStats.h"
+#include <cmath>
+
+namespace UCIC {
+
+// ============================================================================
+// LATENCY SKETCH
+// ============================================================================
+
+LatencySketch::LatencySketch() : count(0), minValue(0), maxValue(0) {}
+
+void LatencySketch::add(uint64 value) {
+    uint32 bucket = bucketOf(value);
+    if (bucket >= buckets.size()) {
+        buckets.resize(bucket + 1, 0);
+    }
+    buckets[bucket]++;
+
+    minValue = count == 0 ? value : std::min(minValue, value);
+    maxValue = count == 0 ? value : std::max(maxValue, value);
+    count++;
+}
+
+void LatencySketch::merge(const LatencySketch& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (other.buckets.size() > buckets.size()) {
+        buckets.resize(other.buckets.size(), 0);
+    }
+    for (size_t i = 0; i < other.buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+
+    minValue = count == 0 ? other.minValue : std::min(minValue, other.minValue);
+    maxValue = count == 0 ? other.maxValue : std::max(maxValue, other.maxValue);
+    count += other.count;
+}
+
+uint64 LatencySketch::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    q = std::min(1.0, std::max(0.0, q));
+    uint64 rank = std::max<uint64>(1, static_cast<uint64>(std::ceil(q * count)));
+    uint64 seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::max(minValue, std::min(maxValue, bucketUpper(static_cast<uint32>(i))));
+        }
+    }
+    return maxValue;
+}
+
+uint64 LatencySketch::getCount() const {
+    return count;
+}
+
+uint64 LatencySketch::getMin() const {
+    return minValue;
+}
+
+uint64 LatencySketch::getMax() const {
+    return maxValue;
+}
+
+uint32 LatencySketch::bucketOf(uint64 value) {
+    if (value < SKETCH_SUB_BUCKETS) {
+        return static_cast<uint32>(value);
+    }
+    uint32 msb = 63 - static_cast<uint32>(__builtin_clzll(value));
+    uint32 shift = msb - 3;  // log2(SKETCH_SUB_BUCKETS)
+    uint32 sub = static_cast<uint32>((value >> shift) & (SKETCH_SUB_BUCKETS - 1));
+    return (msb - 2) * SKETCH_SUB_BUCKETS + sub;
+}
+
+uint64 LatencySketch::bucketUpper(uint32 bucket) {
+    if (bucket < SKETCH_SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32 msb = bucket / SKETCH_SUB_BUCKETS + 2;
+    uint64 sub = bucket % SKETCH_SUB_BUCKETS;
+    uint64 lower = (SKETCH_SUB_BUCKETS + sub) << (msb - 3);
+    return lower + ((1ULL << (msb - 3)) - 1);
+}
+
+}  // namespace UCIC
@@ -0,0 +1,94 @@
+#include "../include/MemoryUsage.h"
+#include <ostream>
+
+namespace UCIC {
+
+// ============================================================================
+// REPORTS
+// ============================================================================
+
+void MemoryUsage::add(const std::string& name, uint64 entries, uint64 bytes) {
+    structures.push_back(StructureUsage{name, entries, bytes});
+}
+
+uint64 MemoryUsage::totalBytes() const {
+    uint64 total = 0;
+    for (const auto& structure : structures) {
+        total += structure.bytes;
+    }
+    return total;
+}
+
+void writeMemoryMetrics(std::ostream& out, const std::vector<MemoryUsage>& reports) {
+    out << "# HELP ucic_structure_entries Entries held by a contract data structure\n"
+        << "# TYPE ucic_structure_entries gauge\n";
+    for (const auto& report : reports) {
+        for (const auto& structure : report.structures) {
+            out << "ucic_structure_entries{contract=\"" << report.contract
+                << "\",structure=\"" << structure.name << "\"} " << structure.entries << "\n";
+        }
+    }
+
+    out << "# HELP ucic_structure_bytes Approximate bytes held by a contract data structure\n"
+        << "# TYPE ucic_structure_bytes gauge\n";
+    for (const auto& report : reports) {
+        for (const auto& structure : report.structures) {
+            out << "ucic_structure_bytes{contract=\"" << report.contract
+                << "\",structure=\"" << structure.name << "\"} " << structure.bytes << "\n";
+        }
+    }
+}
+
+// ============================================================================
+// SIZE ESTIMATES
+// ============================================================================
+
+uint64 heapBytes(const std::string& value) {
+    // Short strings live in the inline buffer
+    static const size_t inlineCapacity = std::string().capacity();
+    return value.capacity() > inlineCapacity ? value.capacity() + 1 : 0;
+}
+
+uint64 heapBytes(const Account& account) {
+    return heapBytes(account.address);
+}
+
+uint64 heapBytes(const AuditTrailChunk& chunk) {
+    return SHARED_BLOCK_OVERHEAD + sizeof(AuditTrailChunk) + heapBytes(chunk.entries);
+}
+
+uint64 heapBytes(const Contributor& contributor) {
+    uint64 bytes = heapBytes(contributor.address);
+    for (const AuditTrailChunk* chunk = contributor.auditTrail.get(); chunk; chunk = chunk->previous.get()) {
+        bytes += heapBytes(*chunk);
+    }
+    return bytes;
+}
+
+uint64 heapBytes(const CategoryScore& score) {
+    return heapBytes(score.evidence);
+}
+
+uint64 heapBytes(const OracleSubmission& submission) {
+    return heapBytes(submission.submitter) + heapBytes(submission.targetContributor) +
+           heapBytes(submission.scores) + heapBytes(submission.verificationChain);
+}
+
+uint64 heapBytes(const Proposal& proposal) {
+    return heapBytes(proposal.proposer) + heapBytes(proposal.title) +
+           heapBytes(proposal.description);
+}
+
+uint64 heapBytes(const Vote& vote) {
+    return heapBytes(vote.voter);
+}
+
+uint64 heapBytes(const WalRecord& record) {
+    return heapBytes(record.account) + heapBytes(record.counterparty) + heapBytes(record.txHash);
+}
+
+uint64 heapBytes(const TransferRecord& record) {
+    return heapBytes(record.txHash) + heapBytes(record.from) + heapBytes(record.to);
+}
+
+}  // namespace UCIC
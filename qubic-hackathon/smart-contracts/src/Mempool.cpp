@@ -0,0 +1,349 @@
+#include "../include/Mempool.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <queue>
+
+namespace UCIC {
+
+Mempool::Mempool(std::shared_ptr<const UCTokenContract> token, uint64 capacity, uint32 blockSize)
+    : token(token),
+      capacity(capacity > 0 ? capacity : MEMPOOL_CAPACITY),
+      blockSize(blockSize > 0 ? blockSize : BLOCK_SIZE),
+      count(0),
+      sequence(0),
+      stats{0, 0, 0, 0, 0} {}
+
+AdmissionResult Mempool::add(const SignedTransaction& tx) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isValidAddress(tx.sender) ||
+        (tx.type != TransactionType::CAST_VOTE && !isValidAddress(tx.target)) ||
+        (tx.type == TransactionType::TRANSFER_FROM && !isValidAddress(tx.owner))) {
+        stats.rejected++;
+        return AdmissionResult::INVALID;
+    }
+
+    auto senderIt = senders.find(tx.sender);
+    if (senderIt != senders.end()) {
+        SenderQueue& queue = senderIt->second;
+        if (queue.tracked && tx.nonce < queue.nextNonce) {
+            stats.rejected++;
+            return AdmissionResult::INVALID;  // Nonce already included
+        }
+
+        auto existing = queue.pending.find(tx.nonce);
+        if (existing != queue.pending.end()) {
+            const SignedTransaction& current = existing->second.tx;
+            bool same = tx.signature.r == current.signature.r &&
+                        tx.signature.s == current.signature.s &&
+                        encodeTransaction(tx) == encodeTransaction(current);
+            if (same) {
+                stats.rejected++;
+                return AdmissionResult::DUPLICATE;
+            }
+
+            // Only a genuine envelope may take the slot; it wins over a
+            // forged occupant whatever that one's fee
+            if (!isGenuine(tx)) {
+                stats.rejected++;
+                return AdmissionResult::INVALID;
+            }
+            if (tx.fee <= current.fee && checkEntry(existing->second)) {
+                stats.rejected++;
+                return AdmissionResult::UNDERPRICED;
+            }
+
+            // Replace-by-fee: same slot, higher fee
+            unverified.erase(FeeKey(current.fee, tx.sender, tx.nonce));
+            byFee.erase(FeeKey(current.fee, tx.sender, tx.nonce));
+            byFee.insert(FeeKey(tx.fee, tx.sender, tx.nonce));
+            existing->second.tx = tx;
+            existing->second.sequence = sequence++;
+            existing->second.verified = true;
+            stats.replaced++;
+            return AdmissionResult::REPLACED;
+        }
+    }
+
+    bool verified = false;
+    if (count >= capacity) {
+        if (!isGenuine(tx)) {
+            stats.rejected++;
+            return AdmissionResult::INVALID;
+        }
+        verified = true;
+
+        FeeKey cheapest = *byFee.begin();
+        if (std::get<0>(cheapest) < tx.fee) {
+            evict(cheapest);
+        }
+
+        // Forged entries cost nothing to submit, so unchecked ones are
+        // verified, highest fee first, before a genuine one is refused;
+        // each entry is verified at most once
+        for (uint32 attempt = 0;
+             count >= capacity && !unverified.empty() && attempt < MEMPOOL_PURGE_ATTEMPTS; ++attempt) {
+            FeeKey key = *unverified.rbegin();
+            if (!checkEntry(*findEntry(key))) {
+                evict(key);
+            }
+        }
+
+        if (count >= capacity) {
+            stats.rejected++;
+            return AdmissionResult::UNDERPRICED;
+        }
+    }
+
+    SenderQueue& queue = senders[tx.sender];
+    Entry entry;
+    entry.tx = tx;
+    entry.sequence = sequence++;
+    entry.verified = verified;
+    queue.pending.emplace(tx.nonce, entry);
+    byFee.insert(FeeKey(tx.fee, tx.sender, tx.nonce));
+    if (!verified) {
+        unverified.insert(FeeKey(tx.fee, tx.sender, tx.nonce));
+    }
+    count++;
+    stats.admitted++;
+
+    return AdmissionResult::ACCEPTED;
+}
+
+std::vector<SignedTransaction> Mempool::buildBlock(const UCTokenContract& token) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Ready heads ordered by fee, then by arrival
+    using Ready = std::tuple<uint64, uint64, SenderQueue*>;
+    auto lower = [](const Ready& a, const Ready& b) {
+        if (std::get<0>(a) != std::get<0>(b)) {
+            return std::get<0>(a) < std::get<0>(b);
+        }
+        return std::get<1>(a) > std::get<1>(b);
+    };
+    std::priority_queue<Ready, std::vector<Ready>, decltype(lower)> ready(lower);
+
+    for (auto it = senders.begin(); it != senders.end();) {
+        SenderQueue& queue = it->second;
+        uint64 onChain = token.getNonce(it->first);
+
+        if (!queue.tracked || queue.nextNonce < onChain) {
+            queue.nextNonce = onChain;
+            queue.tracked = true;
+        }
+
+        // Drop transactions whose nonce has already been used
+        while (!queue.pending.empty() && queue.pending.begin()->first < queue.nextNonce) {
+            erase(queue, queue.pending.begin());
+        }
+
+        if (queue.pending.empty()) {
+            // Nothing in flight beyond the on-chain nonce: forget the sender
+            if (queue.nextNonce <= onChain) {
+                it = senders.erase(it);
+                continue;
+            }
+        } else if (queue.pending.begin()->first == queue.nextNonce) {
+            const Entry& head = queue.pending.begin()->second;
+            ready.push(Ready(head.tx.fee, head.sequence, &queue));
+        }
+        ++it;
+    }
+
+    std::vector<SignedTransaction> block;
+    block.reserve(std::min<uint64>(blockSize, count));
+
+    while (!ready.empty() && block.size() < blockSize) {
+        SenderQueue* queue = std::get<2>(ready.top());
+        ready.pop();
+
+        auto head = queue->pending.begin();
+        block.push_back(head->second.tx);
+        erase(*queue, head);
+        queue->nextNonce++;
+        stats.included++;
+
+        if (!queue->pending.empty() && queue->pending.begin()->first == queue->nextNonce) {
+            const Entry& next = queue->pending.begin()->second;
+            ready.push(Ready(next.tx.fee, next.sequence, queue));
+        }
+    }
+
+    return block;
+}
+
+void Mempool::resync(const PublicAddress& sender) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = senders.find(sender);
+    if (it != senders.end()) {
+        it->second.tracked = false;
+    }
+}
+
+uint64 Mempool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+Mempool::Stats Mempool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+bool Mempool::isGenuine(const SignedTransaction& tx) const {
+    SignerKey bound = token->getBoundKey(tx.sender);
+    return bound != 0 && bound == tx.senderKey && verifyTransaction(tx);
+}
+
+bool Mempool::checkEntry(Entry& entry) {
+    if (!entry.verified && isGenuine(entry.tx)) {
+        entry.verified = true;
+        unverified.erase(FeeKey(entry.tx.fee, entry.tx.sender, entry.tx.nonce));
+    }
+    return entry.verified;
+}
+
+Mempool::Entry* Mempool::findEntry(const FeeKey& key) {
+    auto& pending = senders.find(std::get<1>(key))->second.pending;
+    return &pending.find(std::get<2>(key))->second;
+}
+
+void Mempool::evict(const FeeKey& key) {
+    // Copy: the key may refer to an element of byFee that is about to go
+    PublicAddress sender = std::get<1>(key);
+    uint64 nonce = std::get<2>(key);
+
+    auto senderIt = senders.find(sender);
+    if (senderIt == senders.end()) {
+        return;
+    }
+
+    // Later nonces of the same sender cannot execute without this one
+    SenderQueue& queue = senderIt->second;
+    auto it = queue.pending.find(nonce);
+    while (it != queue.pending.end()) {
+        auto next = std::next(it);
+        erase(queue, it);
+        stats.evicted++;
+        it = next;
+    }
+}
+
+void Mempool::erase(SenderQueue& queue, std::map<uint64, Entry>::iterator it) {
+    FeeKey key(it->second.tx.fee, it->second.tx.sender, it->first);
+    byFee.erase(key);
+    unverified.erase(key);
+    queue.pending.erase(it);
+    count--;
+}
+
+double BlockExecutor::Stats::throughput() const {
+    if (elapsedNanos == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(applied) * 1e9 / static_cast<double>(elapsedNanos);
+}
+
+BlockExecutor::BlockExecutor(std::shared_ptr<UCTokenContract> tokenContract,
+                             std::shared_ptr<UCICDaoContract> daoContract,
+                             uint32 workers)
+    : tokenContract(tokenContract),
+      daoContract(daoContract),
+      verifier(workers),
+      stats{0, 0, 0, 0} {}
+
+std::vector<bool> BlockExecutor::executeBlock(const std::vector<SignedTransaction>& block) {
+    return executeVerified(block, verifier.verifyBatch(block));
+}
+
+std::vector<bool> BlockExecutor::executeVerified(const std::vector<SignedTransaction>& block,
+                                                 const std::vector<bool>& verified) {
+    std::vector<bool> results(block.size(), false);
+    for (size_t i = 0; i < block.size(); ++i) {
+        results[i] = verified[i] && apply(block[i]);
+        if (results[i]) {
+            stats.applied++;
+        } else {
+            stats.failed++;
+        }
+    }
+    stats.blocks++;
+    
+    // One replication commit group per block
+    tokenContract->commitReplication();
+    return results;
+}
+
+uint64 BlockExecutor::drain(Mempool& mempool) {
+    auto start = std::chrono::steady_clock::now();
+    uint64 appliedBefore = stats.applied;
+
+    auto verify = [this](const std::vector<SignedTransaction>* block) {
+        return verifier.verifyBatch(*block);
+    };
+
+    // Double buffer: the block being verified never moves while its
+    // verification task reads it
+    std::vector<SignedTransaction> blocks[2];
+    size_t current = 0;
+
+    blocks[current] = mempool.buildBlock(*tokenContract);
+    std::future<std::vector<bool>> verified = std::async(std::launch::async, verify, &blocks[current]);
+
+    while (!blocks[current].empty()) {
+        std::vector<bool> valid = verified.get();
+
+        // Nonces of in-flight senders are tracked by the mempool, so the
+        // next block can be built and verified before this one executes
+        std::vector<SignedTransaction>& next = blocks[current ^ 1];
+        next = mempool.buildBlock(*tokenContract);
+        std::future<std::vector<bool>> nextVerified;
+        if (!next.empty()) {
+            nextVerified = std::async(std::launch::async, verify, &next);
+        }
+
+        const std::vector<SignedTransaction>& block = blocks[current];
+        std::vector<bool> results = executeVerified(block, valid);
+        for (size_t i = 0; i < block.size(); ++i) {
+            if (!results[i]) {
+                mempool.resync(block[i].sender);
+            }
+        }
+
+        current ^= 1;
+        verified = std::move(nextVerified);
+    }
+
+    stats.elapsedNanos += static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    return stats.applied - appliedBefore;
+}
+
+BlockExecutor::Stats BlockExecutor::getStats() const {
+    return stats;
+}
+
+BatchVerifier::Stats BlockExecutor::getVerificationStats() const {
+    return verifier.getStats();
+}
+
+bool BlockExecutor::apply(const SignedTransaction& tx) {
+    switch (tx.type) {
+        case TransactionType::TRANSFER:
+        case TransactionType::APPROVE:
+        case TransactionType::TRANSFER_FROM:
+            return tokenContract->applyVerifiedTransaction(tx);
+
+        case TransactionType::CAST_VOTE:
+            return daoContract && daoContract->applyVerifiedTransaction(tx);
+
+        default:
+            return false;
+    }
+}
+
+}  // namespace UCIC
@@ -6,10 +6,34 @@
 
 namespace UCIC {
 
+static uint64 heapBytes(const OracleContract::VerificationRecord& record) {
+    return heapBytes(record.verifier) + heapBytes(record.notes);
+}
+
+// Store value under key, keeping the map's memory counter current
+template <typename K, typename V>
+static void assignCounted(std::map<K, V>& map, StructureCounter& usage,
+                          const K& key, const V& value) {
+    auto it = map.find(key);
+    if (it == map.end()) {
+        map.emplace(key, value);
+        usage.insert(heapBytes(key) + heapBytes(value));
+        return;
+    }
+    uint64 before = heapBytes(it->second);
+    it->second = value;
+    usage.resize(before, heapBytes(it->second));
+}
+
 OracleContract::OracleContract(std::shared_ptr<UCICDaoContract> daoContract)
     : daoContract(daoContract),
       totalVerifications(0),
-      acceptedVerifications(0) {}
+      acceptedVerifications(0),
+      pendingChallengeCount(0),
+      verificationTimeTotal(0),
+      verificationTimeCount(0) {
+    submissionsByLevel.fill(0);
+}
 
 TransactionHash OracleContract::submitScore(const PublicAddress& contributor,
                                            uint8 codeQuality,
@@ -47,15 +71,25 @@ TransactionHash OracleContract::submitScore(const PublicAddress& contributor,
     submission.scores.push_back(score5);
     
     TransactionHash submissionId = "sub_" + contributor + "_" + std::to_string(submission.submittedAt);
-    submissions[submissionId] = submission;
+    
+    // A resubmission in the same second replaces the earlier one, but keeps its verifications
+    auto previous = submissions.find(submissionId);
+    uint64 timeBefore = verificationTime(submissionId);
+    if (previous != submissions.end()) {
+        submissionsByLevel[static_cast<uint8>(previous->second.verificationLevel)]--;
+    }
+    assignCounted(submissions, submissionUsage, submissionId, submission);
+    submissionsByLevel[static_cast<uint8>(submission.verificationLevel)]++;
+    countVerificationTime(timeBefore, verificationTime(submissionId));
+    epochStats.at(submission.submittedAt).submissions++;
     
     // Create Merkle proof
     Hash256 merkleRoot = createMerkleProof(submissionId);
-    merkleRoots[submissionId] = merkleRoot;
+    assignCounted(merkleRoots, merkleRootUsage, submissionId, merkleRoot);
     
     // Store Git repository
     if (!gitRepository.empty()) {
-        gitRepositories[contributor] = gitRepository;
+        assignCounted(gitRepositories, repositoryUsage, contributor, gitRepository);
     }
     
     recordAction("submit_score", contributor, submissionId);
@@ -82,7 +116,14 @@ bool OracleContract::verifySubmission(const TransactionHash& submissionId,
     record.notes = notes;
     record.verifiedAt = static_cast<uint64>(std::time(nullptr));
     
-    verificationChains[submissionId].push_back(record);
+    uint64 timeBefore = verificationTime(submissionId);
+    auto chain = verificationChains.emplace(submissionId, std::vector<VerificationRecord>());
+    std::vector<VerificationRecord>& records = chain.first->second;
+    uint64 before = chain.second ? 0 : containerBytes(records);
+    records.push_back(record);
+    verificationUsage.insert(heapBytes(record));
+    verificationUsage.resize(before, containerBytes(records) +
+                                     (chain.second ? heapBytes(submissionId) : 0));
     submission.verifierCount++;
     
     if (approved) {
@@ -91,7 +132,16 @@ bool OracleContract::verifySubmission(const TransactionHash& submissionId,
     
     totalVerifications++;
     
+    EpochStats& epoch = epochStats.at(record.verifiedAt);
+    epoch.verifications++;
+    epoch.acceptedVerifications += approved ? 1 : 0;
+    epoch.verificationLatency.add(record.verifiedAt > submission.submittedAt ?
+                                  record.verifiedAt - submission.submittedAt : 0);
+    
+    countVerificationTime(timeBefore, verificationTime(submissionId));
+    
     // Update verification level based on verifier count
+    submissionsByLevel[static_cast<uint8>(submission.verificationLevel)]--;
     if (submission.verifierCount >= 3) {
         submission.verificationLevel = approved ? 
             VerificationLevel::AUDIT_COMPLETE : VerificationLevel::BASIC;
@@ -99,6 +149,7 @@ bool OracleContract::verifySubmission(const TransactionHash& submissionId,
         submission.verificationLevel = approved ? 
             VerificationLevel::ADVANCED : VerificationLevel::BASIC;
     }
+    submissionsByLevel[static_cast<uint8>(submission.verificationLevel)]++;
     
     recordAction("verify_submission", verifier, submissionId);
     
@@ -137,7 +188,7 @@ bool OracleContract::linkGitRepository(const PublicAddress& contributor,
                                       const std::string& repoUrl,
                                       const GitHash& commitSha) {
     
-    gitRepositories[contributor] = repoUrl;
+    assignCounted(gitRepositories, repositoryUsage, contributor, repoUrl);
     return true;
 }
 
@@ -220,9 +271,17 @@ std::vector<OracleContract::VerificationRecord> OracleContract::getVerificationC
 TransactionHash OracleContract::recordAction(const std::string& action,
                                             const PublicAddress& actor,
                                             const TransactionHash& submissionId) {
-    TransactionHash actionHash = action + "_" + actor + "_" + std::to_string(std::time(nullptr));
-    auditLog.push_back(actionHash);
-    return actionHash;
+    Timestamp now = static_cast<uint64>(std::time(nullptr));
+    auditLog.append(action, actor, submissionId, now);
+    return action + "_" + actor + "_" + std::to_string(now);
+}
+
+const SegmentedLog& OracleContract::getAuditLog() const {
+    return auditLog;
+}
+
+void OracleContract::setLogRetention(uint32 retainedSegments) {
+    auditLog.setRetention(retainedSegments);
 }
 
 bool OracleContract::registerVerifier(const PublicAddress& address) {
@@ -231,6 +290,7 @@ bool OracleContract::registerVerifier(const PublicAddress& address) {
     }
     
     verifiers.insert(address);
+    verifierUsage.insert(heapBytes(address));
     return true;
 }
 
@@ -257,6 +317,7 @@ uint64 OracleContract::getVerifierStats(const PublicAddress& verifier) const {
 bool OracleContract::removeVerifier(const PublicAddress& address) {
     if (verifiers.find(address) != verifiers.end()) {
         verifiers.erase(address);
+        verifierUsage.erase(heapBytes(address));
         return true;
     }
     return false;
@@ -271,7 +332,12 @@ TransactionHash OracleContract::challengeVerification(const TransactionHash& sub
     }
     
     TransactionHash challengeId = "challenge_" + submissionId + "_" + std::to_string(std::time(nullptr));
-    challenges[challengeId] = false;  // Pending resolution
+    auto existing = challenges.find(challengeId);
+    if (existing == challenges.end() || existing->second) {
+        pendingChallengeCount++;
+    }
+    assignCounted(challenges, challengeUsage, challengeId, false);  // Pending resolution
+    epochStats.at(static_cast<uint64>(std::time(nullptr))).challenges++;
     
     recordAction("challenge_verification", challenger, submissionId);
     
@@ -294,6 +360,9 @@ bool OracleContract::resolveChallenge(const TransactionHash& challengeId, bool a
         return false;
     }
     
+    if (!it->second) {
+        pendingChallengeCount--;
+    }
     it->second = true;  // Mark as resolved
     return true;
 }
@@ -324,44 +393,40 @@ bool OracleContract::isRegisteredWithDao(const TransactionHash& submissionId) co
 OracleContract::Statistics OracleContract::getStatistics() const {
     Statistics stats;
     stats.totalSubmissions = submissions.size();
-    stats.verifiedSubmissions = 0;
-    stats.pendingSubmissions = 0;
+    stats.verifiedSubmissions = submissionsByLevel[static_cast<uint8>(VerificationLevel::AUDIT_COMPLETE)];
+    stats.pendingSubmissions = submissionsByLevel[static_cast<uint8>(VerificationLevel::UNVERIFIED)];
     stats.rejectedSubmissions = 0;
     stats.totalVerifiers = verifiers.size();
-    stats.pendingChallenges = getPendingChallenges().size();
+    stats.pendingChallenges = pendingChallengeCount;
     stats.averageVerificationTime = getAverageVerificationTime();
-    
-    for (const auto& sub : submissions) {
-        if (sub.second.verificationLevel == VerificationLevel::AUDIT_COMPLETE) {
-            stats.verifiedSubmissions++;
-        } else if (sub.second.verificationLevel == VerificationLevel::UNVERIFIED) {
-            stats.pendingSubmissions++;
-        }
-    }
-    
     return stats;
 }
 
 uint64 OracleContract::getAverageVerificationTime() const {
-    if (verificationChains.empty()) {
+    return verificationTimeCount > 0 ? verificationTimeTotal / verificationTimeCount : 0;
+}
+
+// Seconds from submission to the latest verification, 0 if none came later
+uint64 OracleContract::verificationTime(const TransactionHash& submissionId) const {
+    auto submission = submissions.find(submissionId);
+    auto chain = verificationChains.find(submissionId);
+    if (submission == submissions.end() || chain == verificationChains.end() || chain->second.empty()) {
         return 0;
     }
-    
-    uint64 totalTime = 0;
-    uint64 count = 0;
-    
-    for (const auto& chain : verificationChains) {
-        if (!chain.second.empty()) {
-            uint64 startTime = submissions.find(chain.first)->second.submittedAt;
-            uint64 endTime = chain.second.back().verifiedAt;
-            if (endTime > startTime) {
-                totalTime += (endTime - startTime);
-                count++;
-            }
-        }
+    uint64 startTime = submission->second.submittedAt;
+    uint64 endTime = chain->second.back().verifiedAt;
+    return endTime > startTime ? endTime - startTime : 0;
+}
+
+void OracleContract::countVerificationTime(uint64 before, uint64 after) {
+    if (before > 0) {
+        verificationTimeTotal -= before;
+        verificationTimeCount--;
+    }
+    if (after > 0) {
+        verificationTimeTotal += after;
+        verificationTimeCount++;
     }
-    
-    return count > 0 ? totalTime / count : 0;
 }
 
 uint8 OracleContract::getAcceptanceRate() const {
@@ -372,6 +437,88 @@ uint8 OracleContract::getAcceptanceRate() const {
     return static_cast<uint8>((acceptedVerifications * 100) / totalVerifications);
 }
 
+OracleContract::EpochStats OracleContract::getRollingStats(uint32 epochs) const {
+    return epochStats.window(static_cast<uint64>(std::time(nullptr)), epochs);
+}
+
+MemoryUsage OracleContract::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.contract = "oracle";
+    usage.add("submissions", submissionUsage.entries,
+              containerBytes(submissions) + submissionUsage.bytes);
+    usage.add("verificationChains", verificationUsage.entries,
+              containerBytes(verificationChains) + verificationUsage.bytes);
+    usage.add("gitRepositories", repositoryUsage.entries,
+              containerBytes(gitRepositories) + repositoryUsage.bytes);
+    usage.add("merkleRoots", merkleRootUsage.entries,
+              containerBytes(merkleRoots) + merkleRootUsage.bytes);
+    usage.add("verifiers", verifierUsage.entries, containerBytes(verifiers) + verifierUsage.bytes);
+    usage.add("auditLog", auditLog.getStats().residentRecords, heapBytes(auditLog));
+    usage.add("challenges", challengeUsage.entries,
+              containerBytes(challenges) + challengeUsage.bytes);
+    return usage;
+}
+
+void OracleContract::exportColumnar(ColumnarWriter& writer) const {
+    struct SubmissionRow {
+        const TransactionHash* id;
+        const OracleSubmission* submission;
+        std::string gitSHA1;
+    };
+    
+    std::vector<SubmissionRow> submissionRows;
+    submissionRows.reserve(submissions.size());
+    for (const auto& entry : submissions) {
+        std::ostringstream sha;
+        sha << std::hex << std::setfill('0');
+        for (uint8 byte : entry.second.gitSHA1) {
+            sha << std::setw(2) << static_cast<int>(byte);
+        }
+        submissionRows.push_back({&entry.first, &entry.second, sha.str()});
+    }
+    
+    writer.writeTable<SubmissionRow>("submissions", submissionRows, {
+        textColumn<SubmissionRow>("submission_id", [](const SubmissionRow& r) -> const std::string& { return *r.id; }),
+        textColumn<SubmissionRow>("submitter", [](const SubmissionRow& r) -> const std::string& { return r.submission->submitter; }),
+        textColumn<SubmissionRow>("target_contributor", [](const SubmissionRow& r) -> const std::string& { return r.submission->targetContributor; }),
+        textColumn<SubmissionRow>("git_sha1", [](const SubmissionRow& r) -> const std::string& { return r.gitSHA1; }),
+        integerColumn<SubmissionRow>("verification_level", ColumnType::UINT8, [](const SubmissionRow& r) { return static_cast<uint64>(r.submission->verificationLevel); }),
+        integerColumn<SubmissionRow>("verifier_count", ColumnType::UINT8, [](const SubmissionRow& r) { return r.submission->verifierCount; }),
+        integerColumn<SubmissionRow>("submitted_at", ColumnType::UINT64, [](const SubmissionRow& r) { return r.submission->submittedAt; })
+    });
+    
+    using VerificationRow = std::pair<const TransactionHash*, const VerificationRecord*>;
+    std::vector<VerificationRow> verificationRows;
+    std::map<PublicAddress, uint64> verifierActivity;
+    for (const auto& chain : verificationChains) {
+        for (const auto& record : chain.second) {
+            verificationRows.emplace_back(&chain.first, &record);
+            verifierActivity[record.verifier]++;
+        }
+    }
+    
+    writer.writeTable<VerificationRow>("verifications", verificationRows, {
+        textColumn<VerificationRow>("submission_id", [](const VerificationRow& r) -> const std::string& { return *r.first; }),
+        textColumn<VerificationRow>("verifier", [](const VerificationRow& r) -> const std::string& { return r.second->verifier; }),
+        integerColumn<VerificationRow>("approved", ColumnType::UINT8, [](const VerificationRow& r) { return r.second->approved ? 1 : 0; }),
+        integerColumn<VerificationRow>("verified_at", ColumnType::UINT64, [](const VerificationRow& r) { return r.second->verifiedAt; })
+    });
+    
+    // One pass over the chains instead of getVerifierStats() per verifier
+    using VerifierRow = std::pair<const PublicAddress*, uint64>;
+    std::vector<VerifierRow> verifierRows;
+    verifierRows.reserve(verifiers.size());
+    for (const auto& verifier : verifiers) {
+        auto it = verifierActivity.find(verifier);
+        verifierRows.emplace_back(&verifier, it != verifierActivity.end() ? it->second : 0);
+    }
+    
+    writer.writeTable<VerifierRow>("verifiers", verifierRows, {
+        textColumn<VerifierRow>("address", [](const VerifierRow& r) -> const std::string& { return *r.first; }),
+        integerColumn<VerifierRow>("verifications", ColumnType::UINT64, [](const VerifierRow& r) { return r.second; })
+    });
+}
+
 Hash256 OracleContract::computeMerkleTree(const OracleSubmission& submission) const {
     Hash256 result{};
     
@@ -0,0 +1,494 @@
+#include "../include/Replication.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace UCIC {
+
+namespace {
+
+void appendUint64(std::string& out, uint64 value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendUint32(std::string& out, uint32 value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendString(std::string& out, const std::string& value) {
+    appendUint32(out, static_cast<uint32>(value.size()));
+    out += value;
+}
+
+uint64 readUint(const char* data, int bytes) {
+    uint64 value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Bounds-checked reader over one frame payload
+class PayloadReader {
+public:
+    PayloadReader(const char* data, size_t size) : data(data), size(size), offset(0), ok(true) {}
+
+    uint64 u64() {
+        if (!require(8)) {
+            return 0;
+        }
+        uint64 value = readUint(data + offset, 8);
+        offset += 8;
+        return value;
+    }
+
+    uint8 u8() {
+        if (!require(1)) {
+            return 0;
+        }
+        return static_cast<uint8>(data[offset++]);
+    }
+
+    std::string str() {
+        if (!require(4)) {
+            return std::string();
+        }
+        size_t length = static_cast<size_t>(readUint(data + offset, 4));
+        offset += 4;
+        if (!require(length)) {
+            return std::string();
+        }
+        std::string value(data + offset, length);
+        offset += length;
+        return value;
+    }
+
+    bool done() const {
+        return ok && offset == size;
+    }
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset;
+    bool ok;
+
+    bool require(size_t bytes) {
+        ok = ok && size - offset >= bytes;
+        return ok;
+    }
+};
+
+uint64 checksum(const char* data, size_t size) {
+    // FNV-1a
+    uint64 h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+uint64 nowNanos() {
+    return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+}  // namespace
+
+// ============================================================================
+// FRAMING
+// ============================================================================
+
+std::string encodeWalFrame(const WalRecord& record) {
+    std::string payload;
+    payload.reserve(1 + 8 + 12 + record.account.size() + record.counterparty.size() +
+                    record.txHash.size() + 5 * 8);
+    payload.push_back(static_cast<char>(record.type));
+    appendUint64(payload, record.sequence);
+    appendString(payload, record.account);
+    appendString(payload, record.counterparty);
+    appendString(payload, record.txHash);
+    appendUint64(payload, record.amount);
+    appendUint64(payload, record.balance);
+    appendUint64(payload, record.nonce);
+    appendUint64(payload, record.publicKey);
+    appendUint64(payload, record.createdAt);
+
+    std::string frame;
+    frame.reserve(4 + payload.size() + 8);
+    appendUint32(frame, static_cast<uint32>(payload.size()));
+    frame += payload;
+    appendUint64(frame, checksum(payload.data(), payload.size()));
+    return frame;
+}
+
+FrameStatus decodeWalFrame(const char* data, size_t size, WalRecord& record, size_t& consumed) {
+    if (size < 4) {
+        return FrameStatus::INCOMPLETE;
+    }
+
+    uint64 length = readUint(data, 4);
+    if (length > WAL_MAX_FRAME_SIZE) {
+        return FrameStatus::CORRUPT;
+    }
+    if (size < 4 + length + 8) {
+        return FrameStatus::INCOMPLETE;
+    }
+
+    const char* payload = data + 4;
+    if (readUint(payload + length, 8) != checksum(payload, length)) {
+        return FrameStatus::CORRUPT;
+    }
+
+    PayloadReader reader(payload, length);
+    uint8 type = reader.u8();
+    record.type = static_cast<WalRecordType>(type);
+    record.sequence = reader.u64();
+    record.account = reader.str();
+    record.counterparty = reader.str();
+    record.txHash = reader.str();
+    record.amount = reader.u64();
+    record.balance = reader.u64();
+    record.nonce = reader.u64();
+    record.publicKey = reader.u64();
+    record.createdAt = reader.u64();
+
+    if (!reader.done() || type > static_cast<uint8>(WalRecordType::COMMIT)) {
+        return FrameStatus::CORRUPT;
+    }
+
+    consumed = static_cast<size_t>(4 + length + 8);
+    return FrameStatus::COMPLETE;
+}
+
+void queueAcknowledgement(std::string& outbox, uint64 appliedSequence) {
+    // Sends consume the outbox from the front, so only its first
+    // acknowledgement can be partially sent: complete it before the next
+    outbox.resize(outbox.size() % 8);
+    appendUint64(outbox, appliedSequence);
+}
+
+// ============================================================================
+// REPLICATION LOG
+// ============================================================================
+
+ReplicationLog::ReplicationLog() : lastSequence(0) {}
+
+uint64 ReplicationLog::append(std::vector<WalRecord> group) {
+    uint64 sequence = ++lastSequence;
+
+    for (auto& record : group) {
+        record.sequence = sequence;
+        records.push_back(std::move(record));
+    }
+
+    WalRecord commit;
+    commit.type = WalRecordType::COMMIT;
+    commit.sequence = sequence;
+    commit.amount = nowNanos();
+    records.push_back(commit);
+
+    return sequence;
+}
+
+uint64 ReplicationLog::getLastSequence() const {
+    return lastSequence;
+}
+
+std::vector<WalRecord> ReplicationLog::readAfter(uint64 afterSequence) const {
+    auto begin = std::upper_bound(records.begin(), records.end(), afterSequence,
+        [](uint64 sequence, const WalRecord& record) { return sequence < record.sequence; });
+    return std::vector<WalRecord>(begin, records.end());
+}
+
+void ReplicationLog::truncate(uint64 throughSequence) {
+    while (!records.empty() && records.front().sequence <= throughSequence) {
+        records.pop_front();
+    }
+}
+
+uint64 ReplicationLog::size() const {
+    return records.size();
+}
+
+// ============================================================================
+// WAL SHIPPER
+// ============================================================================
+
+WalShipper::WalShipper(std::shared_ptr<UCTokenContract> tokenContract)
+    : tokenContract(tokenContract),
+      log(std::make_shared<ReplicationLog>()),
+      nextFollowerId(1),
+      stats{0, 0, 0, 0, 0} {
+    tokenContract->attachReplicationLog(log);
+}
+
+WalShipper::~WalShipper() {
+    tokenContract->attachReplicationLog(nullptr);
+    for (auto& follower : followers) {
+        disconnect(follower);
+    }
+}
+
+uint32 WalShipper::addFollower(int fd) {
+    setNonBlocking(fd);
+
+    // The image reflects exactly the state as of the latest commit group
+    uint64 sequence = tokenContract->commitReplication();
+
+    Follower follower;
+    follower.id = nextFollowerId++;
+    follower.fd = fd;
+    follower.sentSequence = sequence;
+    follower.appliedSequence = 0;
+    follower.outboxOffset = 0;
+    follower.connected = true;
+
+    std::vector<WalRecord> image = tokenContract->exportReplicationImage();
+    for (auto& record : image) {
+        record.sequence = sequence;
+    }
+    WalRecord commit;
+    commit.type = WalRecordType::COMMIT;
+    commit.sequence = sequence;
+    commit.amount = nowNanos();
+    image.push_back(commit);
+
+    queue(follower, image);
+    stats.bootstraps++;
+
+    followers.push_back(std::move(follower));
+    flush(followers.back());
+    return followers.back().id;
+}
+
+uint64 WalShipper::ship() {
+    uint64 sequence = tokenContract->commitReplication();
+    stats.committedSequence = sequence;
+
+    uint64 retainFrom = sequence;
+    for (auto& follower : followers) {
+        if (!follower.connected) {
+            continue;
+        }
+
+        if (follower.sentSequence < sequence) {
+            queue(follower, log->readAfter(follower.sentSequence));
+            follower.sentSequence = sequence;
+        }
+        flush(follower);
+        readAcknowledgements(follower);
+        retainFrom = std::min(retainFrom, follower.sentSequence);
+    }
+
+    // Every connected follower has its copy queued
+    log->truncate(retainFrom);
+    return sequence;
+}
+
+std::vector<WalShipper::FollowerStats> WalShipper::getFollowerStats() const {
+    std::vector<FollowerStats> result;
+    result.reserve(followers.size());
+    for (const auto& follower : followers) {
+        FollowerStats entry;
+        entry.id = follower.id;
+        entry.sentSequence = follower.sentSequence;
+        entry.appliedSequence = follower.appliedSequence;
+        entry.lag = log->getLastSequence() - std::min(follower.appliedSequence, log->getLastSequence());
+        entry.bufferedBytes = follower.outbox.size() - follower.outboxOffset;
+        entry.connected = follower.connected;
+        result.push_back(entry);
+    }
+    return result;
+}
+
+WalShipper::Stats WalShipper::getStats() const {
+    return stats;
+}
+
+void WalShipper::queue(Follower& follower, const std::vector<WalRecord>& records) {
+    for (const auto& record : records) {
+        follower.outbox += encodeWalFrame(record);
+    }
+    stats.recordsShipped += records.size();
+
+    if (follower.outbox.size() - follower.outboxOffset > WAL_MAX_BUFFERED_BYTES) {
+        disconnect(follower);  // Too far behind: must re-bootstrap
+    }
+}
+
+void WalShipper::flush(Follower& follower) {
+    while (follower.connected && follower.outboxOffset < follower.outbox.size()) {
+        ssize_t sent = send(follower.fd, follower.outbox.data() + follower.outboxOffset,
+                            follower.outbox.size() - follower.outboxOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            follower.outboxOffset += static_cast<size_t>(sent);
+            stats.bytesShipped += static_cast<uint64>(sent);
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            break;
+        } else {
+            disconnect(follower);
+        }
+    }
+
+    // Compact once the sent prefix dominates the buffer
+    if (follower.outboxOffset > 0 && follower.outboxOffset * 2 >= follower.outbox.size()) {
+        follower.outbox.erase(0, follower.outboxOffset);
+        follower.outboxOffset = 0;
+    }
+}
+
+void WalShipper::readAcknowledgements(Follower& follower) {
+    char buffer[512];
+    while (follower.connected) {
+        ssize_t received = recv(follower.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            follower.inbox.append(buffer, static_cast<size_t>(received));
+        } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            break;
+        } else {
+            disconnect(follower);
+        }
+    }
+
+    // Acknowledgements are u64 applied sequences; only the latest matters
+    size_t complete = follower.inbox.size() - follower.inbox.size() % 8;
+    if (complete > 0) {
+        follower.appliedSequence = readUint(follower.inbox.data() + complete - 8, 8);
+        follower.inbox.erase(0, complete);
+    }
+}
+
+void WalShipper::disconnect(Follower& follower) {
+    if (follower.connected) {
+        close(follower.fd);
+        follower.connected = false;
+        follower.outbox.clear();
+        follower.outboxOffset = 0;
+        stats.disconnects++;
+    }
+}
+
+// ============================================================================
+// FOLLOWER REPLICA
+// ============================================================================
+
+FollowerReplica::FollowerReplica(int fd)
+    : fd(fd),
+      bootstrapped(false),
+      stats{0, 0, 0, 0, 0, true, false} {
+    setNonBlocking(fd);
+}
+
+FollowerReplica::~FollowerReplica() {
+    if (stats.connected) {
+        close(fd);
+    }
+}
+
+uint64 FollowerReplica::poll() {
+    uint64 groupsBefore = stats.groupsApplied;
+
+    char buffer[64 * 1024];
+    while (stats.connected) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            inbox.append(buffer, static_cast<size_t>(received));
+            stats.bytesReceived += static_cast<uint64>(received);
+        } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            break;
+        } else {
+            close(fd);
+            stats.connected = false;
+        }
+    }
+
+    size_t offset = 0;
+    while (!stats.corrupt) {
+        WalRecord record;
+        size_t consumed = 0;
+        FrameStatus status = decodeWalFrame(inbox.data() + offset, inbox.size() - offset,
+                                            record, consumed);
+        if (status == FrameStatus::INCOMPLETE) {
+            break;
+        }
+        if (status == FrameStatus::CORRUPT) {
+            stats.corrupt = true;  // Stop applying; the replica needs a new bootstrap
+            break;
+        }
+
+        offset += consumed;
+        if (record.type == WalRecordType::COMMIT) {
+            applyGroup(record);
+        } else {
+            pending.push_back(std::move(record));
+        }
+    }
+    inbox.erase(0, offset);
+
+    uint64 applied = stats.groupsApplied - groupsBefore;
+    if (applied > 0) {
+        acknowledge();
+    }
+    return applied;
+}
+
+const UCTokenContract& FollowerReplica::getLedger() const {
+    return ledger;
+}
+
+bool FollowerReplica::isBootstrapped() const {
+    return bootstrapped;
+}
+
+FollowerReplica::Stats FollowerReplica::getStats() const {
+    return stats;
+}
+
+void FollowerReplica::applyGroup(const WalRecord& commit) {
+    bool bootstrap = !pending.empty() && pending.front().type == WalRecordType::BOOTSTRAP;
+
+    // Groups at or below the applied sequence are already reflected
+    if (bootstrap || (bootstrapped && commit.sequence > stats.appliedSequence)) {
+        for (const auto& record : pending) {
+            ledger.applyReplicationRecord(record);
+        }
+        stats.recordsApplied += pending.size();
+        stats.appliedSequence = commit.sequence;
+        stats.groupsApplied++;
+        bootstrapped = true;
+
+        uint64 now = nowNanos();
+        stats.applyLagNanos = now > commit.amount ? now - commit.amount : 0;
+    }
+
+    pending.clear();
+}
+
+void FollowerReplica::acknowledge() {
+    queueAcknowledgement(ackOutbox, stats.appliedSequence);
+
+    if (stats.connected) {
+        ssize_t sent = send(fd, ackOutbox.data(), ackOutbox.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            ackOutbox.erase(0, static_cast<size_t>(sent));
+        }
+    }
+}
+
+}  // namespace UCIC
@@ -0,0 +1,300 @@
+#include "../include/SegmentedLog.h"
+#include "../include/MemoryUsage.h"
+#include <algorithm>
+
+namespace UCIC {
+
+namespace {
+
+const uint8 LEAF_TAG = 0x00;
+const uint8 NODE_TAG = 0x01;
+
+void appendLE(std::string& out, uint64 value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+Hash256 leafHash(const LogRecord& record) {
+    std::string leaf(1, static_cast<char>(LEAF_TAG));
+    appendLE(leaf, record.sequence, 8);
+    appendLE(leaf, record.timestamp, 8);
+    appendLE(leaf, record.action, 4);
+    appendLE(leaf, record.actor, 4);
+    leaf.append(record.subject.begin(), record.subject.end());
+    return SegmentedLog::digest(leaf);
+}
+
+Hash256 nodeHash(const Hash256& left, const Hash256& right) {
+    std::string node(1, static_cast<char>(NODE_TAG));
+    node.append(left.begin(), left.end());
+    node.append(right.begin(), right.end());
+    return SegmentedLog::digest(node);
+}
+
+// Reduces one tree level; an unpaired last node is promoted unchanged
+std::vector<Hash256> parentLevel(const std::vector<Hash256>& level) {
+    std::vector<Hash256> parents;
+    parents.reserve((level.size() + 1) / 2);
+    for (size_t i = 0; i < level.size(); i += 2) {
+        parents.push_back(i + 1 < level.size() ? nodeHash(level[i], level[i + 1]) : level[i]);
+    }
+    return parents;
+}
+
+}  // namespace
+
+SegmentedLog::SegmentedLog(uint32 segmentRecords, uint32 retainedSegments)
+    : segmentRecords(std::max(1u, segmentRecords)),
+      retainedSegments(retainedSegments),
+      nextSequence(1),
+      nameBytes(0) {
+    segments.push_back(Segment{nextSequence, {}, Hash256{}});
+    segments.back().records.reserve(this->segmentRecords);
+    intern("");  // ID 0 is the empty name
+}
+
+uint64 SegmentedLog::append(const std::string& action, const PublicAddress& actor,
+                            const std::string& subject, Timestamp timestamp) {
+    LogRecord record;
+    record.sequence = nextSequence++;
+    record.timestamp = timestamp;
+    record.action = intern(action);
+    record.actor = intern(actor);
+    record.subject = digest(subject);
+
+    Segment& active = segments.back();
+    active.records.push_back(record);
+    if (active.records.size() == segmentRecords) {
+        seal(active);
+        segments.push_back(Segment{nextSequence, {}, Hash256{}});
+        segments.back().records.reserve(segmentRecords);
+        compact();
+    }
+
+    return record.sequence;
+}
+
+void SegmentedLog::setRetention(uint32 retainedSegments) {
+    this->retainedSegments = retainedSegments;
+    compact();
+}
+
+bool SegmentedLog::find(uint64 sequence, LogRecord& record) const {
+    const Segment* segment = findSegment(sequence);
+    if (!segment) {
+        return false;
+    }
+    record = segment->records[sequence - segment->firstSequence];
+    return true;
+}
+
+std::vector<LogRecord> SegmentedLog::getRecent(size_t limit) const {
+    std::vector<LogRecord> recent;
+    for (auto it = segments.rbegin(); it != segments.rend() && recent.size() < limit; ++it) {
+        for (auto rec = it->records.rbegin(); rec != it->records.rend() && recent.size() < limit; ++rec) {
+            recent.push_back(*rec);
+        }
+    }
+    std::reverse(recent.begin(), recent.end());
+    return recent;
+}
+
+const std::string& SegmentedLog::getName(uint32 id) const {
+    return id < names.size() ? names[id] : names[0];
+}
+
+bool SegmentedLog::getProof(uint64 sequence, LogProof& proof) const {
+    const Segment* segment = findSegment(sequence);
+    if (!segment || segment == &segments.back()) {
+        return false;  // Compacted, or not sealed yet
+    }
+
+    proof.sequence = sequence;
+    proof.siblings.clear();
+
+    std::vector<Hash256> level;
+    level.reserve(segment->records.size());
+    for (const auto& record : segment->records) {
+        level.push_back(leafHash(record));
+    }
+
+    size_t index = static_cast<size_t>(sequence - segment->firstSequence);
+    while (level.size() > 1) {
+        size_t sibling = index ^ 1;
+        if (sibling < level.size()) {
+            proof.siblings.push_back(level[sibling]);
+        }
+        level = parentLevel(level);
+        index /= 2;
+    }
+    return true;
+}
+
+bool SegmentedLog::verifyProof(const LogRecord& record, const LogProof& proof) const {
+    Hash256 root{};
+    uint32 count = 0;
+    if (record.sequence != proof.sequence || !rootOf(record.sequence, root, count)) {
+        return false;
+    }
+
+    // The segment containing the sequence starts at a segment boundary
+    size_t index = static_cast<size_t>((record.sequence - 1) % segmentRecords);
+    size_t size = count;
+    size_t used = 0;
+    Hash256 node = leafHash(record);
+    while (size > 1) {
+        size_t sibling = index ^ 1;
+        if (sibling < size) {
+            if (used == proof.siblings.size()) {
+                return false;
+            }
+            const Hash256& other = proof.siblings[used++];
+            node = (index & 1) ? nodeHash(other, node) : nodeHash(node, other);
+        }
+        index /= 2;
+        size = (size + 1) / 2;
+    }
+
+    return used == proof.siblings.size() && node == root;
+}
+
+const std::vector<LogArchive>& SegmentedLog::getArchives() const {
+    return archives;
+}
+
+Hash256 SegmentedLog::digest(const std::string& data) {
+    // Four FNV-1a lanes with distinct seeds and a SplitMix64 finalizer
+    Hash256 result{};
+    for (uint64 lane = 0; lane < 4; ++lane) {
+        uint64 hash = 0xcbf29ce484222325ULL ^ ((lane + 1) * 0x9E3779B97F4A7C15ULL);
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+        for (int i = 0; i < 8; ++i) {
+            result[lane * 8 + i] = static_cast<uint8>((hash >> (8 * i)) & 0xFF);
+        }
+    }
+    return result;
+}
+
+SegmentedLog::Stats SegmentedLog::getStats() const {
+    // Sequences are dense, so resident and archived counts follow from the range
+    Stats stats{};
+    stats.appended = nextSequence - 1;
+    stats.residentRecords = nextSequence - segments.front().firstSequence;
+    stats.sealedSegments = segments.size() - 1;
+    stats.archivedSegments = archives.size();
+    stats.archivedRecords = segments.front().firstSequence - 1;
+    stats.internedNames = names.size() - freeNames.size();
+    return stats;
+}
+
+// Each call takes one reference, dropped by release() at compaction
+uint32 SegmentedLog::intern(const std::string& name) {
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) {
+        nameRefs[it->second]++;
+        return it->second;
+    }
+
+    uint32 id;
+    if (!freeNames.empty()) {
+        id = freeNames.back();
+        freeNames.pop_back();
+        names[id] = name;
+        nameRefs[id] = 1;
+    } else {
+        id = static_cast<uint32>(names.size());
+        names.push_back(name);
+        nameRefs.push_back(1);
+    }
+    nameIds.emplace(name, id);
+    nameBytes += 2 * heapBytes(names[id]);
+    return id;
+}
+
+void SegmentedLog::release(uint32 id) {
+    if (id == 0 || --nameRefs[id] > 0) {
+        return;  // The empty name is never released
+    }
+    nameBytes -= 2 * heapBytes(names[id]);
+    nameIds.erase(names[id]);
+    std::string().swap(names[id]);
+    freeNames.push_back(id);
+}
+
+void SegmentedLog::seal(Segment& segment) {
+    std::vector<Hash256> level;
+    level.reserve(segment.records.size());
+    for (const auto& record : segment.records) {
+        level.push_back(leafHash(record));
+    }
+    while (level.size() > 1) {
+        level = parentLevel(level);
+    }
+    segment.merkleRoot = level.empty() ? Hash256{} : level[0];
+}
+
+void SegmentedLog::compact() {
+    while (segments.size() - 1 > retainedSegments) {
+        const Segment& oldest = segments.front();
+        LogArchive archive;
+        archive.firstSequence = oldest.firstSequence;
+        archive.records = static_cast<uint32>(oldest.records.size());
+        archive.firstTimestamp = oldest.records.front().timestamp;
+        archive.lastTimestamp = oldest.records.back().timestamp;
+        archive.merkleRoot = oldest.merkleRoot;
+        archives.push_back(archive);
+        for (const auto& record : oldest.records) {
+            release(record.action);
+            release(record.actor);
+        }
+        segments.pop_front();
+    }
+}
+
+const SegmentedLog::Segment* SegmentedLog::findSegment(uint64 sequence) const {
+    uint64 first = segments.front().firstSequence;
+    if (sequence < first || sequence >= nextSequence) {
+        return nullptr;
+    }
+    // Every segment but the active one is full
+    return &segments[static_cast<size_t>((sequence - first) / segmentRecords)];
+}
+
+bool SegmentedLog::rootOf(uint64 sequence, Hash256& root, uint32& count) const {
+    auto it = std::upper_bound(archives.begin(), archives.end(), sequence,
+        [](uint64 seq, const LogArchive& archive) { return seq < archive.firstSequence; });
+    if (it != archives.begin() && sequence < (it - 1)->firstSequence + (it - 1)->records) {
+        root = (it - 1)->merkleRoot;
+        count = (it - 1)->records;
+        return true;
+    }
+
+    const Segment* segment = findSegment(sequence);
+    if (!segment || segment == &segments.back()) {
+        return false;
+    }
+    root = segment->merkleRoot;
+    count = static_cast<uint32>(segment->records.size());
+    return true;
+}
+
+uint64 heapBytes(const SegmentedLog& log) {
+    uint64 bytes = containerBytes(log.archives) + containerBytes(log.names) +
+                   containerBytes(log.nameRefs) + containerBytes(log.freeNames) +
+                   containerBytes(log.nameIds) + log.nameBytes;
+    for (const auto& segment : log.segments) {
+        bytes += sizeof(segment) + segment.records.capacity() * sizeof(LogRecord);
+    }
+    return bytes;
+}
+
+}  // namespace UCIC
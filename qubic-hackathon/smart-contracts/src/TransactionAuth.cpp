@@ -0,0 +1,365 @@
+#include "../include/TransactionAuth.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace UCIC {
+
+namespace {
+
+using uint128 = unsigned __int128;
+
+uint64 mulMod(uint64 a, uint64 b, uint64 m) {
+    return static_cast<uint64>((static_cast<uint128>(a) * b) % m);
+}
+
+// Multiplication mod p without a 128-bit division: p = 2^63 - c, so 2^63 = c (mod p)
+uint64 mulModP(uint64 a, uint64 b) {
+    constexpr uint64 MASK = (1ULL << 63) - 1;
+    constexpr uint64 C = (1ULL << 63) - SIGNATURE_GROUP_P;
+    uint128 t = static_cast<uint128>(a) * b;
+    t = (t & MASK) + (t >> 63) * C;
+    t = (t & MASK) + (t >> 63) * C;
+    uint64 r = static_cast<uint64>(t);
+    return r >= SIGNATURE_GROUP_P ? r - SIGNATURE_GROUP_P : r;
+}
+
+uint64 powMod(uint64 base, uint64 exp) {
+    uint64 result = 1;
+    base %= SIGNATURE_GROUP_P;
+    while (exp > 0) {
+        if (exp & 1) {
+            result = mulModP(result, base);
+        }
+        base = mulModP(base, base);
+        exp >>= 1;
+    }
+    return result;
+}
+
+// Binary Jacobi symbol (a/n) for odd n; far cheaper than an exponentiation
+int jacobi(uint64 a, uint64 n) {
+    int result = 1;
+    a %= n;
+    while (a != 0) {
+        int twos = __builtin_ctzll(a);
+        a >>= twos;
+        if ((twos & 1) && ((n & 7) == 3 || (n & 7) == 5)) {
+            result = -result;
+        }
+        if (a < n) {
+            std::swap(a, n);
+            if ((a & 3) == 3 && (n & 3) == 3) {
+                result = -result;
+            }
+        }
+        a -= n;
+    }
+    return n == 1 ? result : 0;
+}
+
+bool isWellFormed(const SignedTransaction& tx) {
+    return tx.senderKey > 0 && tx.senderKey < SIGNATURE_GROUP_P &&
+           tx.signature.r > 0 && tx.signature.r < SIGNATURE_GROUP_P &&
+           tx.signature.s < SIGNATURE_GROUP_Q;
+}
+
+uint64 hash64(const std::string& data) {
+    // FNV-1a with a SplitMix64 finalizer
+    uint64 h = 0xCBF29CE484222325ULL;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001B3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+void appendUint64(std::string& out, uint64 value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendString(std::string& out, const std::string& value) {
+    uint32 length = static_cast<uint32>(value.size());
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+    }
+    out += value;
+}
+
+uint64 computeChallenge(uint64 commitment, SignerKey key, const std::string& message) {
+    std::string buffer = "UCIC/challenge";
+    appendUint64(buffer, commitment);
+    appendUint64(buffer, key);
+    buffer += message;
+    return hash64(buffer) % SIGNATURE_GROUP_Q;
+}
+
+// Pre-parsed signature: challenge computed once, reused across bisection
+struct PendingSignature {
+    uint64 r;
+    uint64 y;
+    uint64 s;
+    uint64 e;
+};
+
+// Interleaved (Straus) multi-exponentiation with 4-bit fixed windows.
+// Squarings are shared by all bases, table lookups replace data-dependent
+// branches, and bases are split over independent accumulators so
+// consecutive modular multiplications do not wait on each other.
+uint64 multiExp(const std::vector<uint64>& bases, const std::vector<uint64>& exps) {
+    constexpr size_t LANES = 4;
+    constexpr int WINDOW = 4;
+    constexpr size_t TABLE = 1 << WINDOW;
+
+    std::vector<uint64> table(bases.size() * TABLE);
+    for (size_t j = 0; j < bases.size(); ++j) {
+        uint64* row = &table[j * TABLE];
+        row[0] = 1;
+        for (size_t k = 1; k < TABLE; ++k) {
+            row[k] = mulModP(row[k - 1], bases[j]);
+        }
+    }
+
+    uint64 acc[LANES] = {1, 1, 1, 1};
+    for (int shift = 64 - WINDOW; shift >= 0; shift -= WINDOW) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            for (int k = 0; k < WINDOW; ++k) {
+                acc[lane] = mulModP(acc[lane], acc[lane]);
+            }
+        }
+        for (size_t j = 0; j < bases.size(); ++j) {
+            size_t digit = (exps[j] >> shift) & (TABLE - 1);
+            acc[j % LANES] = mulModP(acc[j % LANES], table[j * TABLE + digit]);
+        }
+    }
+    return mulModP(mulModP(acc[0], acc[1]), mulModP(acc[2], acc[3]));
+}
+
+bool checkSingle(const PendingSignature& sig) {
+    uint64 lhs = powMod(SIGNATURE_GROUP_G, sig.s);
+    uint64 rhs = mulModP(sig.r, powMod(sig.y, sig.e));
+    return lhs == rhs || lhs == SIGNATURE_GROUP_P - rhs;
+}
+
+bool checkCombined(const std::vector<PendingSignature>& sigs, size_t begin, size_t end,
+                   std::mt19937_64& rng) {
+    std::vector<uint64> bases;
+    std::vector<uint64> exps;
+    bases.reserve(2 * (end - begin) + 1);
+    exps.reserve(2 * (end - begin) + 1);
+
+    uint64 sumS = 0;
+    for (size_t i = begin; i < end; ++i) {
+        uint64 z = rng() % SIGNATURE_GROUP_Q;
+        if (z == 0) {
+            z = 1;
+        }
+        sumS = (sumS + mulMod(z, sigs[i].s, SIGNATURE_GROUP_Q)) % SIGNATURE_GROUP_Q;
+        bases.push_back(sigs[i].r);
+        exps.push_back(z);
+        bases.push_back(sigs[i].y);
+        exps.push_back(mulMod(z, sigs[i].e, SIGNATURE_GROUP_Q));
+    }
+    bases.push_back(SIGNATURE_GROUP_G);
+    exps.push_back((SIGNATURE_GROUP_Q - sumS) % SIGNATURE_GROUP_Q);
+
+    uint64 combined = multiExp(bases, exps);
+    return combined == 1 || combined == SIGNATURE_GROUP_P - 1;
+}
+
+// Verify [begin, end); on failure bisect until the invalid entries are isolated
+void resolve(const std::vector<PendingSignature>& sigs, const std::vector<size_t>& index,
+             size_t begin, size_t end, uint8* results, std::mt19937_64& rng) {
+    if (end - begin <= 2) {
+        for (size_t i = begin; i < end; ++i) {
+            results[index[i]] = checkSingle(sigs[i]) ? 1 : 0;
+        }
+        return;
+    }
+
+    if (checkCombined(sigs, begin, end, rng)) {
+        for (size_t i = begin; i < end; ++i) {
+            results[index[i]] = 1;
+        }
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    resolve(sigs, index, begin, mid, results, rng);
+    resolve(sigs, index, mid, end, results, rng);
+}
+
+}  // namespace
+
+std::string encodeTransaction(const SignedTransaction& tx) {
+    std::string out;
+    out.reserve(1 + 4 + tx.sender.size() + 8 + 8 + 4 + tx.target.size() + 4 + tx.owner.size() +
+                8 + 8 + 1);
+    out.push_back(static_cast<char>(tx.type));
+    appendString(out, tx.sender);
+    appendUint64(out, tx.senderKey);
+    appendUint64(out, tx.nonce);
+    appendString(out, tx.target);
+    appendString(out, tx.owner);
+    appendUint64(out, tx.amount);
+    appendUint64(out, tx.fee);
+    out.push_back(static_cast<char>(tx.choice));
+    return out;
+}
+
+bool isValidPublicKey(SignerKey key) {
+    // Quadratic residues mod a safe prime are exactly the order-q subgroup
+    return key > 0 && key < SIGNATURE_GROUP_P && jacobi(key, SIGNATURE_GROUP_P) == 1;
+}
+
+SignerKey derivePublicKey(uint64 secretKey) {
+    uint64 x = secretKey % SIGNATURE_GROUP_Q;
+    if (x == 0) {
+        return 0;
+    }
+    return powMod(SIGNATURE_GROUP_G, x);
+}
+
+Signature signTransaction(const SignedTransaction& tx, uint64 secretKey) {
+    Signature sig;
+    uint64 x = secretKey % SIGNATURE_GROUP_Q;
+    if (x == 0) {
+        return sig;
+    }
+
+    std::string message = encodeTransaction(tx);
+
+    // Deterministic nonce: k = H(x || message)
+    std::string nonceInput = "UCIC/nonce";
+    appendUint64(nonceInput, x);
+    nonceInput += message;
+    uint64 k = hash64(nonceInput) % SIGNATURE_GROUP_Q;
+    if (k == 0) {
+        k = 1;
+    }
+
+    sig.r = powMod(SIGNATURE_GROUP_G, k);
+    uint64 e = computeChallenge(sig.r, tx.senderKey, message);
+    sig.s = (k + mulMod(e, x, SIGNATURE_GROUP_Q)) % SIGNATURE_GROUP_Q;
+    return sig;
+}
+
+bool verifyTransaction(const SignedTransaction& tx) {
+    if (!isWellFormed(tx)) {
+        return false;
+    }
+
+    PendingSignature sig;
+    sig.r = tx.signature.r;
+    sig.y = tx.senderKey;
+    sig.s = tx.signature.s;
+    sig.e = computeChallenge(sig.r, sig.y, encodeTransaction(tx));
+    return checkSingle(sig);
+}
+
+double BatchVerifier::Stats::throughput() const {
+    if (elapsedNanos == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(verified + rejected) * 1e9 / static_cast<double>(elapsedNanos);
+}
+
+BatchVerifier::BatchVerifier(uint32 workers, uint32 batchSize)
+    : workers(workers),
+      batchSize(batchSize > 0 ? batchSize : SIGNATURE_BATCH_SIZE),
+      stats{0, 0, 0, 0} {
+    if (this->workers == 0) {
+        this->workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+std::vector<bool> BatchVerifier::verifyBatch(const std::vector<SignedTransaction>& txs) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<uint8> results(txs.size(), 0);
+    size_t chunkCount = (txs.size() + batchSize - 1) / batchSize;
+    uint64 seed = (static_cast<uint64>(std::random_device{}()) << 32) ^ std::random_device{}();
+
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < chunkCount) {
+            size_t begin = chunk * batchSize;
+            size_t end = std::min(txs.size(), begin + batchSize);
+            verifyRange(txs, begin, end, results.data(), seed + chunk);
+        }
+    };
+
+    size_t threadCount = std::min<size_t>(workers, chunkCount);
+    if (threadCount <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::vector<bool> valid(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        valid[i] = results[i] != 0;
+        if (valid[i]) {
+            stats.verified++;
+        } else {
+            stats.rejected++;
+        }
+    }
+    stats.batches += chunkCount;
+    stats.elapsedNanos += static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    return valid;
+}
+
+BatchVerifier::Stats BatchVerifier::getStats() const {
+    return stats;
+}
+
+void BatchVerifier::verifyRange(const std::vector<SignedTransaction>& txs,
+                                size_t begin, size_t end, uint8* results, uint64 seed) const {
+    std::vector<PendingSignature> sigs;
+    std::vector<size_t> index;
+    sigs.reserve(end - begin);
+    index.reserve(end - begin);
+
+    for (size_t i = begin; i < end; ++i) {
+        const SignedTransaction& tx = txs[i];
+        // Malformed entries fail outright and stay out of the batch
+        if (!isWellFormed(tx)) {
+            results[i] = 0;
+            continue;
+        }
+
+        PendingSignature sig;
+        sig.r = tx.signature.r;
+        sig.y = tx.senderKey;
+        sig.s = tx.signature.s;
+        sig.e = computeChallenge(sig.r, sig.y, encodeTransaction(tx));
+        sigs.push_back(sig);
+        index.push_back(i);
+    }
+
+    std::mt19937_64 rng(seed);
+    resolve(sigs, index, 0, sigs.size(), results, rng);
+}
+
+}  // namespace UCIC
@@ -1,19 +1,61 @@
 #include "../include/UCICDaoContract.h"
 #include <algorithm>
 #include <ctime>
+#include <iterator>
 #include <numeric>
 
 namespace UCIC {
 
-UCICDaoContract::UCICDaoContract(std::shared_ptr<UCTokenContract> tokenContract)
+namespace {
+
+constexpr size_t RESCORE_BLOCK_ROWS = 256;
+
+// Composite scores of a range of score table rows
+// Each product fits a uint16 lane (at most 255 * TOTAL_WEIGHT), so the
+// inner loops compile to packed multiply-adds over whole blocks of rows
+void weightedScores(const std::array<const uint8*, NUM_SCORE_CATEGORIES>& categories,
+                    const ScoringWeights& weights, const uint32* bonusPoints,
+                    uint32* scores, size_t rows) {
+    uint16 sums[RESCORE_BLOCK_ROWS];
+    for (size_t begin = 0; begin < rows; begin += RESCORE_BLOCK_ROWS) {
+        size_t count = std::min(RESCORE_BLOCK_ROWS, rows - begin);
+        std::fill(sums, sums + count, 0);
+        for (size_t category = 0; category < NUM_SCORE_CATEGORIES; ++category) {
+            const uint8* column = categories[category] + begin;
+            uint16 weight = weights.weights[category];
+            for (size_t i = 0; i < count; ++i) {
+                sums[i] = static_cast<uint16>(sums[i] + column[i] * weight);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            scores[begin + i] = sums[i] / ScoringWeights::TOTAL_WEIGHT + bonusPoints[begin + i];
+        }
+    }
+}
+
+}  // namespace
+
+UCICDaoContract::UCICDaoContract(std::shared_ptr<UCTokenContract> tokenContract, Clock clock)
     : tokenContract(tokenContract),
+      clock(clock),
+      executedProposals(0),
+      openDeadlines(std::make_shared<std::vector<Timestamp>>()),
       nextProposalId(1),
       totalRewardsDistributed(0),
-      lastRewardDistribution(0) {}
+      lastRewardDistribution(0),
+      stateVersion(0),
+      snapshotClock(0),
+      totalVotingPower(0),
+      leaderboardBytes(0) {
+    rewardPerMember.fill(0);
+    rewardCarry.fill(0);
+    tierMembers.fill(0);
+    publishSnapshot();
+}
 
 bool UCICDaoContract::registerContributor(const PublicAddress& address,
                                          const PublicAddress& referrer) {
-    if (contributors.find(address) != contributors.end()) {
+    if (contributors.find(address)) {
         return false;  // Already registered
     }
     
@@ -23,27 +65,45 @@ bool UCICDaoContract::registerContributor(const PublicAddress& address,
     contrib.compositeScore = 0;
     contrib.pointsEarned = 0;
     contrib.rewardsReceived = 0;
-    contrib.joinedAt = static_cast<uint64>(std::time(nullptr));
+    contrib.joinedAt = currentTime();
     contrib.lastRewardClaimAt = 0;
+    contrib.rewardCheckpoint = rewardPerMember[static_cast<uint8>(ContributorTier::RECOGNIZED)];
+    contrib.accruedRewards = 0;
+    contrib.scoreRow = static_cast<uint32>(scoreTable.addresses.size());
     
-    contributors[address] = contrib;
-    
-    TransactionHash txHash = "register_" + address + "_" + std::to_string(std::time(nullptr));
+    for (auto& column : scoreTable.categories) {
+        column.push_back(0);
+    }
+    scoreTable.bonusPoints.push_back(0);
+    scoreTable.compositeScores.push_back(0);
+    scoreTable.tiers.push_back(static_cast<uint8>(ContributorTier::RECOGNIZED));
+    scoreTable.addresses.push_back(address);
+    scoreUsage.insert(heapBytes(address));
+    leaderboard.reset();
+    
+    contributors.insert(address, contrib);
+    contributorUsage.insert(heapBytes(address) + heapBytes(contrib));
+    epochStats.at(contrib.joinedAt).newContributors++;
+    tierMembers[static_cast<uint8>(ContributorTier::RECOGNIZED)]++;
+    recordVotingPower(address, 0, getTierVotingPower(ContributorTier::RECOGNIZED));
+    
+    TransactionHash txHash = "register_" + address + "_" + std::to_string(currentTime());
     recordGovernanceAction("register_contributor", address, txHash);
+    publishSnapshot();
     
     return true;
 }
 
 Contributor UCICDaoContract::getContributor(const PublicAddress& address) const {
-    auto it = contributors.find(address);
-    if (it != contributors.end()) {
-        return it->second;
+    const Contributor* contrib = contributors.find(address);
+    if (contrib) {
+        return *contrib;
     }
     return Contributor();
 }
 
 bool UCICDaoContract::isContributor(const PublicAddress& address) const {
-    return contributors.find(address) != contributors.end();
+    return contributors.find(address) != nullptr;
 }
 
 uint64 UCICDaoContract::getContributorCount() const {
@@ -52,32 +112,37 @@ uint64 UCICDaoContract::getContributorCount() const {
 
 bool UCICDaoContract::submitCompositeScore(const PublicAddress& contributor,
                                           const std::vector<CategoryScore>& scores) {
-    auto it = contributors.find(contributor);
-    if (it == contributors.end()) {
+    Contributor* contrib = contributors.mutate(contributor);
+    if (!contrib) {
         return false;
     }
     
-    // Calculate new composite score
-    uint32 newScore = 0;
-    uint8 counts[5] = {0};
-    uint8 values[5] = {0};
+    // Categories missing from the submission score 0
+    uint8 values[NUM_SCORE_CATEGORIES] = {0};
     
     for (const auto& score : scores) {
         int idx = static_cast<int>(score.category);
-        if (idx >= 0 && idx < 5) {
+        if (idx >= 0 && idx < NUM_SCORE_CATEGORIES) {
             values[idx] = score.score;
-            counts[idx]++;
         }
     }
     
-    newScore = calculateCompositeScore(values[0], values[1], values[2], values[3], values[4]);
-    it->second.compositeScore = newScore;
-    it->second.pointsEarned += newScore;
+    // Kept so the composite can be recomputed when the weights change
+    uint32 row = contrib->scoreRow;
+    for (size_t category = 0; category < NUM_SCORE_CATEGORIES; ++category) {
+        scoreTable.categories[category][row] = values[category];
+    }
+    scoreTable.bonusPoints[row] = 0;  // A submission replaces earlier bonuses
     
-    updateTier(contributor);
+    uint32 newScore = calculateCompositeScore(values[0], values[1], values[2], values[3], values[4]);
+    setCompositeScore(*contrib, newScore);
+    contrib->pointsEarned += newScore;
     
-    TransactionHash txHash = "score_" + contributor + "_" + std::to_string(std::time(nullptr));
-    it->second.auditTrail.push_back(txHash);
+    TransactionHash txHash = "score_" + contributor + "_" + std::to_string(currentTime());
+    appendAuditTrail(*contrib, txHash);
+    
+    updateTier(contributor);
+    publishSnapshot();
     
     return true;
 }
@@ -85,25 +150,96 @@ bool UCICDaoContract::submitCompositeScore(const PublicAddress& contributor,
 uint32 UCICDaoContract::calculateCompositeScore(uint8 codeQuality, uint8 documentation,
                                                uint8 testing, uint8 innovation,
                                                uint8 community) const {
-    return (codeQuality * ScoringWeights::CODE_QUALITY_WEIGHT +
-            documentation * ScoringWeights::DOCUMENTATION_WEIGHT +
-            testing * ScoringWeights::TESTING_WEIGHT +
-            innovation * ScoringWeights::INNOVATION_WEIGHT +
-            community * ScoringWeights::COMMUNITY_WEIGHT) / 100;
+    return (codeQuality * scoringWeights.get(ScoreCategory::CODE_QUALITY) +
+            documentation * scoringWeights.get(ScoreCategory::DOCUMENTATION) +
+            testing * scoringWeights.get(ScoreCategory::TESTING) +
+            innovation * scoringWeights.get(ScoreCategory::INNOVATION) +
+            community * scoringWeights.get(ScoreCategory::COMMUNITY_IMPACT)) / ScoringWeights::TOTAL_WEIGHT;
+}
+
+const ScoringWeights& UCICDaoContract::getScoringWeights() const {
+    return scoringWeights;
+}
+
+uint64 UCICDaoContract::rescoreAll() {
+    const size_t rows = scoreTable.addresses.size();
+    
+    // Vectorized sweep: composite scores, then tiers, for every row
+    std::array<const uint8*, NUM_SCORE_CATEGORIES> categories;
+    for (size_t category = 0; category < NUM_SCORE_CATEGORIES; ++category) {
+        categories[category] = scoreTable.categories[category].data();
+    }
+    std::vector<uint32> scores(rows);
+    weightedScores(categories, scoringWeights, scoreTable.bonusPoints.data(), scores.data(), rows);
+    
+    const uint32 silver = getTierThreshold(ContributorTier::SILVER);
+    const uint32 gold = getTierThreshold(ContributorTier::GOLD);
+    const uint32 platinum = getTierThreshold(ContributorTier::PLATINUM);
+    std::vector<uint8> tiers(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        tiers[i] = static_cast<uint8>((scores[i] >= silver) + (scores[i] >= gold) + (scores[i] >= platinum));
+    }
+    
+    // Write back changed rows; voting power changes share one snapshot
+    uint64 changed = 0;
+    uint64 snapshot = snapshotClock + 1;
+    bool powerChanged = false;
+    
+    for (size_t i = 0; i < rows; ++i) {
+        if (scores[i] == scoreTable.compositeScores[i]) {
+            continue;
+        }
+        changed++;
+        
+        Contributor* contrib = contributors.mutate(scoreTable.addresses[i]);
+        contrib->compositeScore = scores[i];
+        
+        auto newTier = static_cast<ContributorTier>(tiers[i]);
+        if (newTier != contrib->tier) {
+            uint64 oldPower = getTierVotingPower(contrib->tier);
+            uint64 newPower = getTierVotingPower(newTier);
+            totalVotingPower = totalVotingPower - oldPower + newPower;
+            appendCheckpoint(contrib->address, snapshot, newPower);
+            powerChanged = true;
+            
+            settleRewards(*contrib);
+            contrib->tier = newTier;
+            contrib->rewardCheckpoint = rewardPerMember[tiers[i]];
+        }
+    }
+    
+    if (powerChanged) {
+        snapshotClock = snapshot;
+        totalVotingPowerHistory.emplace_back(snapshotClock, totalVotingPower);
+    }
+    
+    scoreTable.compositeScores.swap(scores);
+    scoreTable.tiers.swap(tiers);
+    
+    // Tier counts are rebuilt from the tier column
+    tierMembers.fill(0);
+    for (uint8 tier : scoreTable.tiers) {
+        tierMembers[tier]++;
+    }
+    
+    rebuildLeaderboard();
+    publishSnapshot();
+    
+    return changed;
 }
 
 uint32 UCICDaoContract::getCompositeScore(const PublicAddress& address) const {
-    auto it = contributors.find(address);
-    if (it != contributors.end()) {
-        return it->second.compositeScore;
+    const Contributor* contrib = contributors.find(address);
+    if (contrib) {
+        return contrib->compositeScore;
     }
     return 0;
 }
 
 ContributorTier UCICDaoContract::getTier(const PublicAddress& address) const {
-    auto it = contributors.find(address);
-    if (it != contributors.end()) {
-        return it->second.tier;
+    const Contributor* contrib = contributors.find(address);
+    if (contrib) {
+        return contrib->tier;
     }
     return ContributorTier::RECOGNIZED;
 }
@@ -121,84 +257,74 @@ uint32 UCICDaoContract::getTierThreshold(ContributorTier tier) const {
 
 std::vector<PublicAddress> UCICDaoContract::getContributorsInTier(ContributorTier tier) const {
     std::vector<PublicAddress> result;
-    for (const auto& contrib : contributors) {
-        if (contrib.second.tier == tier) {
-            result.push_back(contrib.first);
-        }
-    }
+    getSnapshot()->contributors.forEach(
+        [&](const PublicAddress& address, const Contributor& contrib) {
+            if (contrib.tier == tier) {
+                result.push_back(address);
+            }
+        });
     return result;
 }
 
 uint64 UCICDaoContract::distributeMonthlyRewards(Timestamp timestamp) {
     uint64 rewardedCount = 0;
     uint64 monthlyPool = UC_TO_UNITS(MONTHLY_REWARD_POOL);
+    uint64 credited = 0;
     
-    // Calculate rewards by tier
-    std::map<ContributorTier, std::vector<PublicAddress>> tierGroups;
-    for (const auto& contrib : contributors) {
-        tierGroups[contrib.second.tier].push_back(contrib.first);
-    }
-    
-    // Distribute rewards proportionally
-    for (int tierIdx = static_cast<int>(ContributorTier::FOUNDER); tierIdx >= 0; --tierIdx) {
-        ContributorTier tier = static_cast<ContributorTier>(tierIdx);
-        auto it = tierGroups.find(tier);
-        
-        if (it == tierGroups.end() || it->second.empty()) {
+    // Credit each tier's accumulator; members settle lazily. Shares of
+    // empty tiers and per-member remainders are not paid out
+    for (uint8 tierIdx = 0; tierIdx < NUM_TIERS; ++tierIdx) {
+        if (tierMembers[tierIdx] == 0) {
             continue;
         }
         
-        uint8 percentage = REWARD_DISTRIBUTION[tierIdx];
-        uint64 tierReward = (monthlyPool * percentage) / 100;
-        uint64 perContributorReward = tierReward / it->second.size();
-        
-        for (const auto& address : it->second) {
-            if (tokenContract->distributeReward(address, perContributorReward)) {
-                auto contrib_it = contributors.find(address);
-                if (contrib_it != contributors.end()) {
-                    contrib_it->second.rewardsReceived += perContributorReward;
-                    contrib_it->second.lastRewardClaimAt = timestamp;
-                    rewardedCount++;
-                }
-            }
-        }
+        uint64 tierReward = (monthlyPool * REWARD_DISTRIBUTION[tierIdx]) / 100 + rewardCarry[tierIdx];
+        uint64 perMember = tierReward / tierMembers[tierIdx];
+        rewardPerMember[tierIdx] += perMember;
+        rewardCarry[tierIdx] = tierReward % tierMembers[tierIdx];
+        rewardedCount += tierMembers[tierIdx];
+        credited += perMember * tierMembers[tierIdx];
     }
     
-    totalRewardsDistributed += monthlyPool;
+    totalRewardsDistributed += credited;
     lastRewardDistribution = timestamp;
+    epochStats.at(currentTime()).rewardsDistributed += credited;
     
     TransactionHash txHash = "reward_dist_" + std::to_string(timestamp);
     recordGovernanceAction("distribute_monthly_rewards", "__DAO__", txHash);
+    publishSnapshot();
     
     return rewardedCount;
 }
 
 uint64 UCICDaoContract::getPendingReward(const PublicAddress& address) const {
-    auto it = contributors.find(address);
-    if (it == contributors.end()) {
+    const Contributor* contrib = contributors.find(address);
+    if (!contrib) {
         return 0;
     }
     
-    // Simplified: return based on tier
-    ContributorTier tier = it->second.tier;
-    uint8 percentage = REWARD_DISTRIBUTION[static_cast<uint8>(tier)];
-    uint64 monthlyPool = UC_TO_UNITS(MONTHLY_REWARD_POOL);
-    
-    return (monthlyPool * percentage) / 100;
+    return contrib->accruedRewards +
+           (rewardPerMember[static_cast<uint8>(contrib->tier)] - contrib->rewardCheckpoint);
 }
 
 uint64 UCICDaoContract::claimRewards(const PublicAddress& contributor) {
-    auto it = contributors.find(contributor);
-    if (it == contributors.end()) {
+    Contributor* contrib = contributors.mutate(contributor);
+    if (!contrib) {
         return 0;
     }
     
-    uint64 pending = getPendingReward(contributor);
-    if (pending > 0) {
-        it->second.rewardsReceived += pending;
-        it->second.lastRewardClaimAt = static_cast<uint64>(std::time(nullptr));
+    settleRewards(*contrib);
+    uint64 pending = contrib->accruedRewards;
+    if (pending == 0 || !tokenContract->distributeReward(contributor, pending)) {
+        return 0;
     }
     
+    contrib->accruedRewards = 0;
+    contrib->rewardsReceived += pending;
+    contrib->lastRewardClaimAt = currentTime();
+    epochStats.at(contrib->lastRewardClaimAt).rewardsClaimed += pending;
+    publishSnapshot();
+    
     return pending;
 }
 
@@ -222,24 +348,71 @@ uint32 UCICDaoContract::createProposal(const PublicAddress& proposer,
     proposal.votesFor = 0;
     proposal.votesAgainst = 0;
     proposal.votesAbstain = 0;
-    proposal.createdAt = static_cast<uint64>(std::time(nullptr));
+    proposal.createdAt = currentTime();
     proposal.votingDeadline = proposal.createdAt + (PROPOSAL_VOTING_PERIOD_HOURS * 3600);
     proposal.executionTime = 0;
+    proposal.snapshotId = snapshotClock;
+    proposal.totalVotingPower = totalVotingPower;
     
-    proposals[proposal.proposalId] = proposal;
+    proposals.insert(proposal.proposalId, proposal);
+    proposalUsage.insert(heapBytes(proposal));
+    setVotingOpen(proposal.votingDeadline, true);
+    epochStats.at(proposal.createdAt).proposals++;
     
     TransactionHash txHash = "proposal_" + std::to_string(proposal.proposalId);
     recordGovernanceAction("create_proposal", proposer, txHash);
+    publishSnapshot();
     
     return proposal.proposalId;
 }
 
-bool UCICDaoContract::castVote(uint32 proposalId, const PublicAddress& voter, VoteType voteType) {
-    auto prop_it = proposals.find(proposalId);
-    if (prop_it == proposals.end()) {
+uint32 UCICDaoContract::createWeightsProposal(const PublicAddress& proposer,
+                                             const std::string& title,
+                                             const std::string& description,
+                                             const ScoringWeights& weights) {
+    if (!weights.isValid()) {
+        return 0;
+    }
+    
+    uint32 proposalId = createProposal(proposer, title, description);
+    if (proposalId != 0) {
+        weightProposals[proposalId] = weights;
+    }
+    return proposalId;
+}
+
+bool UCICDaoContract::finalizeProposal(uint32 proposalId) {
+    const Proposal* current = proposals.find(proposalId);
+    if (!current || !isVotingOpen(*current) ||
+        currentTime() < current->votingDeadline) {
         return false;
     }
     
+    Proposal* proposal = proposals.mutate(proposalId);
+    uint64 cast = proposal->votesFor + proposal->votesAgainst + proposal->votesAbstain;
+    bool quorum = cast * 100 >= static_cast<uint64>(MIN_VOTING_THRESHOLD_PERCENT) * proposal->totalVotingPower;
+    bool passed = quorum && proposal->votesFor > proposal->votesAgainst;
+    proposal->status = passed ? ProposalStatus::PASSED : ProposalStatus::FAILED;
+    setVotingOpen(proposal->votingDeadline, false);
+    
+    if (!passed) {
+        weightProposals.erase(proposalId);
+    }
+    
+    TransactionHash txHash = "finalize_" + std::to_string(proposalId);
+    recordGovernanceAction(passed ? "proposal_passed" : "proposal_failed", proposal->proposer, txHash);
+    publishSnapshot();
+    
+    return passed;
+}
+
+bool UCICDaoContract::castVote(uint32 proposalId, const PublicAddress& voter, VoteType voteType) {
+    const Proposal* proposal = proposals.find(proposalId);
+    if (!proposal || !isVotingOpen(*proposal) ||
+        currentTime() >= proposal->votingDeadline) {
+        return false;  // Finalized or past the deadline
+    }
+    
     if (!isContributor(voter)) {
         return false;
     }
@@ -249,48 +422,89 @@ bool UCICDaoContract::castVote(uint32 proposalId, const PublicAddress& voter, Vo
         return false;
     }
     
-    uint64 votingPower = getVotingPower(voter);
+    uint64 votingPower = getVotingPowerAt(voter, proposal->snapshotId);
+    if (votingPower == 0) {
+        return false;  // Not a contributor at the snapshot
+    }
     
     Vote vote;
     vote.proposalId = proposalId;
     vote.voter = voter;
     vote.voteType = voteType;
     vote.votingPower = votingPower;
-    vote.votedAt = static_cast<uint64>(std::time(nullptr));
+    vote.votedAt = currentTime();
     
     votes[{proposalId, voter}] = vote;
+    voteUsage.insert(heapBytes(voter) + heapBytes(vote));
+    
+    EpochStats& epoch = epochStats.at(vote.votedAt);
+    epoch.votes++;
+    epoch.votingPowerCast += votingPower;
     
     // Update proposal vote counts
+    Proposal* tally = proposals.mutate(proposalId);
     if (voteType == VoteType::FOR) {
-        prop_it->second.votesFor += votingPower;
+        tally->votesFor += votingPower;
     } else if (voteType == VoteType::AGAINST) {
-        prop_it->second.votesAgainst += votingPower;
+        tally->votesAgainst += votingPower;
     } else {
-        prop_it->second.votesAbstain += votingPower;
+        tally->votesAbstain += votingPower;
     }
+    publishSnapshot();
     
     return true;
 }
 
+bool UCICDaoContract::applyVerifiedTransaction(const SignedTransaction& tx) {
+    if (tx.type != TransactionType::CAST_VOTE ||
+        tx.choice > static_cast<uint8>(VoteType::ABSTAIN) ||
+        tx.amount > UINT32_MAX) {
+        return false;
+    }
+    
+    if (!tokenContract->isAuthorized(tx)) {
+        return false;
+    }
+    
+    if (!castVote(static_cast<uint32>(tx.amount), tx.sender, static_cast<VoteType>(tx.choice))) {
+        return false;
+    }
+    
+    return tokenContract->settleTransaction(tx);
+}
+
 bool UCICDaoContract::executeProposal(uint32 proposalId) {
-    auto it = proposals.find(proposalId);
-    if (it == proposals.end() || it->second.status != ProposalStatus::PASSED) {
+    const Proposal* current = proposals.find(proposalId);
+    if (!current || current->status != ProposalStatus::PASSED) {
         return false;
     }
     
-    it->second.status = ProposalStatus::EXECUTED;
-    it->second.executionTime = static_cast<uint64>(std::time(nullptr));
+    Proposal* proposal = proposals.mutate(proposalId);
+    proposal->status = ProposalStatus::EXECUTED;
+    executedProposals++;
+    proposal->executionTime = currentTime();
+    epochStats.at(proposal->executionTime).executedProposals++;
     
     TransactionHash txHash = "execute_" + std::to_string(proposalId);
-    recordGovernanceAction("execute_proposal", it->second.proposer, txHash);
+    recordGovernanceAction("execute_proposal", proposal->proposer, txHash);
+    
+    auto weights = weightProposals.find(proposalId);
+    if (weights != weightProposals.end()) {
+        scoringWeights = weights->second;
+        weightProposals.erase(weights);
+        recordGovernanceAction("update_scoring_weights", "__DAO__", txHash);
+        rescoreAll();  // Publishes the snapshot
+    } else {
+        publishSnapshot();
+    }
     
     return true;
 }
 
 Proposal UCICDaoContract::getProposal(uint32 proposalId) const {
-    auto it = proposals.find(proposalId);
-    if (it != proposals.end()) {
-        return it->second;
+    const Proposal* proposal = proposals.find(proposalId);
+    if (proposal) {
+        return *proposal;
     }
     return Proposal();
 }
@@ -300,37 +514,63 @@ uint64 UCICDaoContract::getVotingPower(const PublicAddress& address) const {
     return getTierVotingPower(tier);
 }
 
+uint64 UCICDaoContract::getVotingPowerAt(const PublicAddress& address, uint64 snapshotId) const {
+    auto it = votingPowerHistory.find(address);
+    if (it == votingPowerHistory.end()) {
+        return 0;
+    }
+    
+    // Last checkpoint at or before the snapshot
+    const std::vector<VotingCheckpoint>& history = it->second;
+    auto next = std::upper_bound(history.begin(), history.end(), snapshotId,
+        [](uint64 snapshot, const VotingCheckpoint& cp) { return snapshot < cp.snapshotId; });
+    return next == history.begin() ? 0 : std::prev(next)->votingPower;
+}
+
+uint64 UCICDaoContract::getTotalVotingPowerAt(uint64 snapshotId) const {
+    auto next = std::upper_bound(totalVotingPowerHistory.begin(), totalVotingPowerHistory.end(), snapshotId,
+        [](uint64 snapshot, const VotingCheckpoint& cp) { return snapshot < cp.snapshotId; });
+    return next == totalVotingPowerHistory.begin() ? 0 : std::prev(next)->votingPower;
+}
+
+uint64 UCICDaoContract::getCurrentSnapshot() const {
+    return snapshotClock;
+}
+
 bool UCICDaoContract::hasVoted(uint32 proposalId, const PublicAddress& voter) const {
     return votes.find({proposalId, voter}) != votes.end();
 }
 
 std::vector<uint32> UCICDaoContract::getActiveProposals() const {
     std::vector<uint32> result;
-    auto now = static_cast<uint64>(std::time(nullptr));
+    auto now = currentTime();
     
-    for (const auto& prop : proposals) {
-        if (prop.second.status == ProposalStatus::ACTIVE ||
-            prop.second.status == ProposalStatus::PENDING) {
-            if (prop.second.votingDeadline > now) {
-                result.push_back(prop.first);
+    getSnapshot()->proposals.forEach([&](uint32 proposalId, const Proposal& proposal) {
+        if (proposal.status == ProposalStatus::ACTIVE ||
+            proposal.status == ProposalStatus::PENDING) {
+            if (proposal.votingDeadline > now) {
+                result.push_back(proposalId);
             }
         }
-    }
+    });
     
+    std::sort(result.begin(), result.end());
     return result;
 }
 
 bool UCICDaoContract::applyModuleBonus(const PublicAddress& contributor,
                                       uint32 moduleId, uint32 bonusPoints) {
-    auto it = contributors.find(contributor);
-    if (it == contributors.end()) {
+    Contributor* contrib = contributors.mutate(contributor);
+    if (!contrib) {
         return false;
     }
     
-    it->second.compositeScore += bonusPoints;
-    it->second.pointsEarned += bonusPoints;
+    scoreTable.bonusPoints[contrib->scoreRow] += bonusPoints;
+    setCompositeScore(*contrib, contrib->compositeScore + bonusPoints);
+    contrib->pointsEarned += bonusPoints;
     
     updateTier(contributor);
+    publishSnapshot();
     
     return true;
 }
@@ -345,60 +585,135 @@ std::map<uint32, uint32> UCICDaoContract::getAvailableBonuses() const {
 }
 
 std::vector<TransactionHash> UCICDaoContract::getAuditTrail(const PublicAddress& address) const {
-    auto it = contributors.find(address);
-    if (it != contributors.end()) {
-        return it->second.auditTrail;
+    std::vector<TransactionHash> trail;
+    const Contributor* contrib = getSnapshot()->contributors.find(address);
+    if (contrib) {
+        for (const AuditTrailChunk* chunk = contrib->auditTrail.get(); chunk; chunk = chunk->previous.get()) {
+            trail.insert(trail.end(), chunk->entries.rbegin(), chunk->entries.rend());
+        }
+        std::reverse(trail.begin(), trail.end());
     }
-    return std::vector<TransactionHash>();
+    return trail;
 }
 
 void UCICDaoContract::recordGovernanceAction(const std::string& action,
                                            const PublicAddress& actor,
                                            const TransactionHash& txHash) {
-    governanceLog.push_back(txHash);
+    governanceLog.append(action, actor, txHash, currentTime());
+}
+
+const SegmentedLog& UCICDaoContract::getGovernanceLog() const {
+    return governanceLog;
+}
+
+void UCICDaoContract::setLogRetention(uint32 retainedSegments) {
+    governanceLog.setRetention(retainedSegments);
 }
 
 bool UCICDaoContract::verifyIntegrity() const {
-    for (const auto& contrib : contributors) {
-        if (contrib.second.address != contrib.first) {
+    bool consistent = true;
+    contributors.forEach([&](const PublicAddress& address, const Contributor& contrib) {
+        consistent = consistent && contrib.address == address;
+    });
+    if (!consistent) {
+        return false;
+    }
+    
+    // Tallies must be reproducible from the votes and the snapshot powers
+    std::map<uint32, std::array<uint64, 3>> tallies;
+    for (const auto& entry : votes) {
+        const Vote& vote = entry.second;
+        const Proposal* proposal = proposals.find(vote.proposalId);
+        if (!proposal ||
+            vote.votingPower != getVotingPowerAt(vote.voter, proposal->snapshotId)) {
             return false;
         }
+        tallies[vote.proposalId][static_cast<uint8>(vote.voteType)] += vote.votingPower;
     }
-    return true;
+    
+    proposals.forEach([&](uint32 proposalId, const Proposal& proposal) {
+        std::array<uint64, 3> tally = {0, 0, 0};
+        auto it = tallies.find(proposalId);
+        if (it != tallies.end()) {
+            tally = it->second;
+        }
+        consistent = consistent &&
+                     proposal.votesFor == tally[static_cast<uint8>(VoteType::FOR)] &&
+                     proposal.votesAgainst == tally[static_cast<uint8>(VoteType::AGAINST)] &&
+                     proposal.votesAbstain == tally[static_cast<uint8>(VoteType::ABSTAIN)];
+    });
+    
+    return consistent;
+}
+
+MemoryUsage UCICDaoContract::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.contract = "dao";
+    usage.add("contributors", contributors.size(), contributors.nodeBytes() + contributorUsage.bytes);
+    usage.add("proposals", proposals.size(), proposals.nodeBytes() + proposalUsage.bytes);
+    usage.add("votes", voteUsage.entries, containerBytes(votes) + voteUsage.bytes);
+    
+    uint64 scoreBytes = containerBytes(scoreTable.bonusPoints) +
+                        containerBytes(scoreTable.compositeScores) +
+                        containerBytes(scoreTable.tiers) +
+                        containerBytes(scoreTable.addresses) + scoreUsage.bytes;
+    for (const auto& column : scoreTable.categories) {
+        scoreBytes += containerBytes(column);
+    }
+    if (leaderboard) {
+        scoreBytes += leaderboardBytes;
+    }
+    usage.add("scoreTable", scoreUsage.entries, scoreBytes);
+    usage.add("governanceLog", governanceLog.getStats().residentRecords, heapBytes(governanceLog));
+    usage.add("votingPowerHistory", checkpointUsage.entries + totalVotingPowerHistory.size(),
+              containerBytes(votingPowerHistory) + checkpointUsage.bytes +
+              containerBytes(totalVotingPowerHistory));
+    return usage;
 }
 
 UCICDaoContract::Statistics UCICDaoContract::getStatistics() const {
-    Statistics stats;
-    stats.totalContributors = contributors.size();
-    stats.totalVotingPower = 0;
-    stats.totalRewardsDistributed = totalRewardsDistributed;
-    stats.activeProposals = getActiveProposals().size();
-    stats.executedProposals = 0;
-    stats.lastRewardDistributionTime = lastRewardDistribution;
+    std::shared_ptr<const StateSnapshot> snapshot = getSnapshot();
+    auto now = currentTime();
     
-    for (const auto& contrib : contributors) {
-        stats.totalVotingPower += getVotingPower(contrib.first);
-        stats.contributorsByTier[contrib.second.tier]++;
-    }
-    
-    for (const auto& prop : proposals) {
-        if (prop.second.status == ProposalStatus::EXECUTED) {
-            stats.executedProposals++;
-        }
-    }
+    const std::vector<Timestamp>& deadlines = *snapshot->openDeadlines;
     
+    Statistics stats;
+    stats.totalContributors = snapshot->contributors.size();
+    stats.totalVotingPower = snapshot->totalVotingPower;
+    stats.totalRewardsDistributed = snapshot->totalRewardsDistributed;
+    stats.activeProposals = static_cast<uint64>(
+        deadlines.end() - std::upper_bound(deadlines.begin(), deadlines.end(), now));
+    stats.executedProposals = snapshot->executedProposals;
+    stats.contributorsByTier = getTierDistribution(*snapshot);
+    stats.lastRewardDistributionTime = snapshot->lastRewardDistribution;
     return stats;
 }
 
 std::vector<PublicAddress> UCICDaoContract::getTopContributors(uint64 limit) const {
+    std::shared_ptr<const StateSnapshot> snapshot = getSnapshot();
+    
+    // The index holds every contributor, or at least the top LEADERBOARD_SIZE
+    if (snapshot->leaderboard &&
+        (limit <= snapshot->leaderboard->size() ||
+         snapshot->leaderboard->size() == snapshot->contributors.size())) {
+        std::vector<PublicAddress> result;
+        for (size_t i = 0; i < limit && i < snapshot->leaderboard->size(); ++i) {
+            result.push_back((*snapshot->leaderboard)[i].first);
+        }
+        return result;
+    }
+    
     std::vector<std::pair<PublicAddress, uint32>> sorted;
+    sorted.reserve(snapshot->contributors.size());
     
-    for (const auto& contrib : contributors) {
-        sorted.push_back({contrib.first, contrib.second.compositeScore});
-    }
+    snapshot->contributors.forEach([&](const PublicAddress& address, const Contributor& contrib) {
+        sorted.push_back({address, contrib.compositeScore});
+    });
     
-    std::sort(sorted.begin(), sorted.end(),
-        [](const auto& a, const auto& b) { return a.second > b.second; });
+    // Ties broken by address so the ranking does not depend on storage order
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
     
     std::vector<PublicAddress> result;
     for (size_t i = 0; i < limit && i < sorted.size(); ++i) {
@@ -408,23 +723,101 @@ std::vector<PublicAddress> UCICDaoContract::getTopContributors(uint64 limit) con
     return result;
 }
 
+UCICDaoContract::EpochStats UCICDaoContract::getRollingStats(uint32 epochs) const {
+    return epochStats.window(currentTime(), epochs);
+}
+
 std::map<ContributorTier, uint64> UCICDaoContract::getTierDistribution() const {
+    return getTierDistribution(*getSnapshot());
+}
+
+std::map<ContributorTier, uint64> UCICDaoContract::getTierDistribution(const StateSnapshot& snapshot) {
+    // Only tiers with members, as when counting the contributors
     std::map<ContributorTier, uint64> distribution;
-    
-    for (const auto& contrib : contributors) {
-        distribution[contrib.second.tier]++;
+    for (uint8 tier = 0; tier < NUM_TIERS; ++tier) {
+        if (snapshot.tierMembers[tier] > 0) {
+            distribution[static_cast<ContributorTier>(tier)] = snapshot.tierMembers[tier];
+        }
     }
-    
     return distribution;
 }
 
+std::shared_ptr<const UCICDaoContract::StateSnapshot> UCICDaoContract::getSnapshot() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return published;
+}
+
+void UCICDaoContract::exportColumnar(ColumnarWriter& writer) const {
+    std::shared_ptr<const StateSnapshot> snapshot = getSnapshot();
+    
+    using ContributorRow = const Contributor*;
+    std::vector<ContributorRow> contributorRows;
+    contributorRows.reserve(snapshot->contributors.size());
+    snapshot->contributors.forEach([&](const PublicAddress&, const Contributor& contrib) {
+        contributorRows.push_back(&contrib);
+    });
+    std::sort(contributorRows.begin(), contributorRows.end(),
+        [](ContributorRow a, ContributorRow b) { return a->address < b->address; });
+    
+    writer.writeTable<ContributorRow>("contributors", contributorRows, {
+        textColumn<ContributorRow>("address", [](ContributorRow c) -> const std::string& { return c->address; }),
+        integerColumn<ContributorRow>("tier", ColumnType::UINT8, [](ContributorRow c) { return static_cast<uint64>(c->tier); }),
+        integerColumn<ContributorRow>("composite_score", ColumnType::UINT32, [](ContributorRow c) { return c->compositeScore; }),
+        integerColumn<ContributorRow>("points_earned", ColumnType::UINT64, [](ContributorRow c) { return c->pointsEarned; }),
+        integerColumn<ContributorRow>("rewards_received", ColumnType::UINT64, [](ContributorRow c) { return c->rewardsReceived; }),
+        integerColumn<ContributorRow>("accrued_rewards", ColumnType::UINT64, [](ContributorRow c) { return c->accruedRewards; }),
+        integerColumn<ContributorRow>("joined_at", ColumnType::UINT64, [](ContributorRow c) { return c->joinedAt; }),
+        integerColumn<ContributorRow>("last_reward_claim_at", ColumnType::UINT64, [](ContributorRow c) { return c->lastRewardClaimAt; })
+    });
+    
+    using ProposalRow = const Proposal*;
+    std::vector<ProposalRow> proposalRows;
+    proposalRows.reserve(snapshot->proposals.size());
+    snapshot->proposals.forEach([&](uint32, const Proposal& proposal) {
+        proposalRows.push_back(&proposal);
+    });
+    std::sort(proposalRows.begin(), proposalRows.end(),
+        [](ProposalRow a, ProposalRow b) { return a->proposalId < b->proposalId; });
+    
+    writer.writeTable<ProposalRow>("proposals", proposalRows, {
+        integerColumn<ProposalRow>("proposal_id", ColumnType::UINT32, [](ProposalRow p) { return p->proposalId; }),
+        textColumn<ProposalRow>("proposer", [](ProposalRow p) -> const std::string& { return p->proposer; }),
+        textColumn<ProposalRow>("title", [](ProposalRow p) -> const std::string& { return p->title; }),
+        integerColumn<ProposalRow>("status", ColumnType::UINT8, [](ProposalRow p) { return static_cast<uint64>(p->status); }),
+        integerColumn<ProposalRow>("votes_for", ColumnType::UINT64, [](ProposalRow p) { return p->votesFor; }),
+        integerColumn<ProposalRow>("votes_against", ColumnType::UINT64, [](ProposalRow p) { return p->votesAgainst; }),
+        integerColumn<ProposalRow>("votes_abstain", ColumnType::UINT64, [](ProposalRow p) { return p->votesAbstain; }),
+        integerColumn<ProposalRow>("created_at", ColumnType::UINT64, [](ProposalRow p) { return p->createdAt; }),
+        integerColumn<ProposalRow>("voting_deadline", ColumnType::UINT64, [](ProposalRow p) { return p->votingDeadline; }),
+        integerColumn<ProposalRow>("snapshot_id", ColumnType::UINT64, [](ProposalRow p) { return p->snapshotId; }),
+        integerColumn<ProposalRow>("total_voting_power", ColumnType::UINT64, [](ProposalRow p) { return p->totalVotingPower; })
+    });
+}
+
+void UCICDaoContract::publishSnapshot() {
+    auto snapshot = std::make_shared<StateSnapshot>();
+    snapshot->contributors = contributors.snapshot();
+    snapshot->proposals = proposals.snapshot();
+    snapshot->totalVotingPower = totalVotingPower;
+    snapshot->totalRewardsDistributed = totalRewardsDistributed;
+    snapshot->lastRewardDistribution = lastRewardDistribution;
+    snapshot->version = stateVersion++;
+    snapshot->leaderboard = leaderboard;
+    snapshot->tierMembers = tierMembers;
+    snapshot->executedProposals = executedProposals;
+    snapshot->openDeadlines = openDeadlines;
+    
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    published = std::move(snapshot);
+}
+
 void UCICDaoContract::updateTier(const PublicAddress& address) {
-    auto it = contributors.find(address);
-    if (it == contributors.end()) {
+    const Contributor* current = contributors.find(address);
+    if (!current) {
         return;
     }
     
-    uint32 score = it->second.compositeScore;
+    uint32 score = current->compositeScore;
     ContributorTier newTier = ContributorTier::RECOGNIZED;
     
     if (score >= getTierThreshold(ContributorTier::PLATINUM)) {
@@ -437,13 +830,126 @@ void UCICDaoContract::updateTier(const PublicAddress& address) {
         newTier = ContributorTier::RECOGNIZED;
     }
     
-    it->second.tier = newTier;
+    if (newTier == current->tier) {
+        return;
+    }
+    
+    Contributor* contrib = contributors.mutate(address);
+    recordVotingPower(address, getTierVotingPower(contrib->tier), getTierVotingPower(newTier));
+    
+    // Rewards earned in the old tier are settled at the switch point
+    settleRewards(*contrib);
+    tierMembers[static_cast<uint8>(contrib->tier)]--;
+    tierMembers[static_cast<uint8>(newTier)]++;
+    contrib->tier = newTier;
+    contrib->rewardCheckpoint = rewardPerMember[static_cast<uint8>(newTier)];
+    scoreTable.tiers[contrib->scoreRow] = static_cast<uint8>(newTier);
+}
+
+void UCICDaoContract::setCompositeScore(Contributor& contrib, uint32 score) {
+    contrib.compositeScore = score;
+    scoreTable.compositeScores[contrib.scoreRow] = score;
+    leaderboard.reset();  // Stale until the next rescoreAll()
+}
+
+void UCICDaoContract::rebuildLeaderboard() {
+    const std::vector<uint32>& scores = scoreTable.compositeScores;
+    std::vector<uint32> rows(scores.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    
+    // Select on the score column first, then order only the candidates;
+    // every row tied with the cutoff score stays in, for the address tie-break
+    if (rows.size() > LEADERBOARD_SIZE) {
+        std::nth_element(rows.begin(), rows.begin() + (LEADERBOARD_SIZE - 1), rows.end(),
+            [&](uint32 a, uint32 b) { return scores[a] > scores[b]; });
+        uint32 cutoff = scores[rows[LEADERBOARD_SIZE - 1]];
+        rows.erase(std::partition(rows.begin(), rows.end(),
+                       [&](uint32 row) { return scores[row] >= cutoff; }),
+                   rows.end());
+    }
+    
+    std::sort(rows.begin(), rows.end(), [&](uint32 a, uint32 b) {
+        return scores[a] != scores[b] ? scores[a] > scores[b]
+                                      : scoreTable.addresses[a] < scoreTable.addresses[b];
+    });
+    if (rows.size() > LEADERBOARD_SIZE) {
+        rows.resize(LEADERBOARD_SIZE);
+    }
+    
+    auto ranked = std::make_shared<std::vector<std::pair<PublicAddress, uint32>>>();
+    ranked->reserve(rows.size());
+    for (uint32 row : rows) {
+        ranked->emplace_back(scoreTable.addresses[row], scores[row]);
+    }
+    leaderboardBytes = heapBytes(*ranked);
+    leaderboard = std::move(ranked);
+}
+
+void UCICDaoContract::recordVotingPower(const PublicAddress& address,
+                                        uint64 oldPower, uint64 newPower) {
+    snapshotClock++;
+    totalVotingPower = totalVotingPower - oldPower + newPower;
+    appendCheckpoint(address, snapshotClock, newPower);
+    totalVotingPowerHistory.emplace_back(snapshotClock, totalVotingPower);
+}
+
+void UCICDaoContract::appendCheckpoint(const PublicAddress& address, uint64 snapshot,
+                                       uint64 votingPower) {
+    auto inserted = votingPowerHistory.emplace(address, std::vector<VotingCheckpoint>());
+    std::vector<VotingCheckpoint>& history = inserted.first->second;
+    uint64 before = inserted.second ? 0 : containerBytes(history);
+    history.emplace_back(snapshot, votingPower);
+    checkpointUsage.insert();
+    checkpointUsage.resize(before, containerBytes(history) +
+                                   (inserted.second ? heapBytes(address) : 0));
+}
+
+void UCICDaoContract::settleRewards(Contributor& contrib) const {
+    uint64 current = rewardPerMember[static_cast<uint8>(contrib.tier)];
+    contrib.accruedRewards += current - contrib.rewardCheckpoint;
+    contrib.rewardCheckpoint = current;
+}
+
+void UCICDaoContract::appendAuditTrail(Contributor& contrib, const TransactionHash& txHash) {
+    // The newest chunk may be shared with a snapshot: replace it, never append in place
+    auto chunk = std::make_shared<AuditTrailChunk>();
+    chunk->entries.reserve(AUDIT_TRAIL_CHUNK_SIZE);
+    if (contrib.auditTrail && contrib.auditTrail->entries.size() < AUDIT_TRAIL_CHUNK_SIZE) {
+        chunk->entries.insert(chunk->entries.end(),
+                              contrib.auditTrail->entries.begin(), contrib.auditTrail->entries.end());
+        chunk->previous = contrib.auditTrail->previous;
+        contributorUsage.resize(heapBytes(*contrib.auditTrail), 0);
+    } else {
+        chunk->previous = contrib.auditTrail;
+    }
+    chunk->entries.push_back(txHash);
+    contributorUsage.resize(0, heapBytes(*chunk));
+    contrib.auditTrail = chunk;
+}
+
+Timestamp UCICDaoContract::currentTime() const {
+    return clock ? clock() : static_cast<uint64>(std::time(nullptr));
 }
 
 bool UCICDaoContract::validateProposal(const Proposal& proposal) const {
     return !proposal.title.empty() && !proposal.description.empty();
 }
 
+bool UCICDaoContract::isVotingOpen(const Proposal& proposal) const {
+    return proposal.status == ProposalStatus::PENDING || proposal.status == ProposalStatus::ACTIVE;
+}
+
+void UCICDaoContract::setVotingOpen(Timestamp votingDeadline, bool open) {
+    // Published snapshots keep the previous list
+    auto deadlines = std::make_shared<std::vector<Timestamp>>(*openDeadlines);
+    if (open) {
+        deadlines->insert(std::upper_bound(deadlines->begin(), deadlines->end(), votingDeadline), votingDeadline);
+    } else {
+        deadlines->erase(std::lower_bound(deadlines->begin(), deadlines->end(), votingDeadline));
+    }
+    openDeadlines = std::move(deadlines);
+}
+
 uint64 UCICDaoContract::calculateRewardAmount(ContributorTier tier) const {
     uint8 percentage = REWARD_DISTRIBUTION[static_cast<uint8>(tier)];
     uint64 monthlyPool = UC_TO_UNITS(MONTHLY_REWARD_POOL);
@@ -1,21 +1,30 @@
 #include "../include/UCTokenContract.h"
+#include "../include/Replication.h"
 #include <algorithm>
 #include <numeric>
 #include <ctime>
 
 namespace UCIC {
 
-UCTokenContract::UCTokenContract()
+namespace {
+
+// Orders allowance table entries against a spender ID
+bool spenderBefore(const std::pair<AccountId, uint64>& entry, AccountId spender) {
+    return entry.first < spender;
+}
+
+}  // namespace
+
+UCTokenContract::UCTokenContract(SignerKey treasuryKey)
     : totalSupply(UC_TOKEN_SUPPLY * UC_UNIT),
       treasuryBalance(0),
       transactionCount(0),
       treasuryAddress("__TREASURY__") {
     
     // Initialize treasury account
-    Account treasury(treasuryAddress);
+    Account& treasury = ensureAccount(treasuryAddress);
     treasury.balance = totalSupply;
-    treasury.createdAt = static_cast<uint64>(std::time(nullptr));
-    accounts[treasuryAddress] = treasury;
+    setBoundKey(treasury, isValidPublicKey(treasuryKey) ? treasuryKey : 0);
     treasuryBalance = totalSupply;
 }
 
@@ -39,6 +48,10 @@ uint64 UCTokenContract::getTreasuryBalance() const {
     return treasuryBalance;
 }
 
+const PublicAddress& UCTokenContract::getTreasuryAddress() const {
+    return treasuryAddress;
+}
+
 uint64 UCTokenContract::balanceOf(const PublicAddress& account) const {
     auto it = accounts.find(account);
     if (it != accounts.end()) {
@@ -49,114 +62,58 @@ uint64 UCTokenContract::balanceOf(const PublicAddress& account) const {
 
 uint64 UCTokenContract::allowance(const PublicAddress& owner, 
                                   const PublicAddress& spender) const {
-    auto it = allowances.find({owner, spender});
-    if (it != allowances.end()) {
+    auto ownerIt = accounts.find(owner);
+    auto spenderIt = accounts.find(spender);
+    if (ownerIt == accounts.end() || spenderIt == accounts.end()) {
+        return 0;
+    }
+    
+    const AllowanceTable& table = allowanceTables[ownerIt->second.id];
+    AccountId spenderId = spenderIt->second.id;
+    auto it = std::lower_bound(table.begin(), table.end(), spenderId, spenderBefore);
+    if (it != table.end() && it->first == spenderId) {
         return it->second;
     }
     return 0;
 }
 
-bool UCTokenContract::transfer(const PublicAddress& recipient, uint64 amount) {
-    if (!validateAddress(recipient) || !validateAmount(amount)) {
-        return false;
-    }
-    
-    auto it = accounts.find(treasuryAddress);
-    if (it == accounts.end() || it->second.balance < amount) {
+bool UCTokenContract::bindAccountKey(const PublicAddress& account, SignerKey publicKey) {
+    if (!validateAddress(account) || account == treasuryAddress || !isValidPublicKey(publicKey)) {
         return false;
     }
     
-    // Register recipient if not exists
-    if (accounts.find(recipient) == accounts.end()) {
-        Account newAccount(recipient);
-        newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-        accounts[recipient] = newAccount;
+    if (accounts.find(account) != accounts.end()) {
+        return false;  // Existing accounts keep their key, or lack of one
     }
     
-    // Transfer
-    accounts[treasuryAddress].balance -= amount;
-    accounts[recipient].balance += amount;
-    accounts[treasuryAddress].nonce++;
-    
-    // Record transaction
-    TransactionHash txHash = "tx_" + std::to_string(transactionCount++);
-    recordTransaction(treasuryAddress, recipient, amount, txHash);
-    
+    setBoundKey(ensureAccount(account), publicKey);
+    markAccount(account);
     return true;
 }
 
-bool UCTokenContract::transferFrom(const PublicAddress& owner,
-                                  const PublicAddress& recipient,
-                                  uint64 amount) {
-    if (!validateAddress(owner) || !validateAddress(recipient) || !validateAmount(amount)) {
-        return false;
-    }
-    
-    // Check allowance
-    uint64 allowed = allowance(owner, recipient);
-    if (allowed < amount) {
+bool UCTokenContract::submitTransaction(const SignedTransaction& tx) {
+    if (!verifyTransaction(tx)) {
         return false;
     }
-    
-    // Check owner balance
-    auto ownerIt = accounts.find(owner);
-    if (ownerIt == accounts.end() || ownerIt->second.balance < amount) {
-        return false;
-    }
-    
-    // Register recipient if not exists
-    if (accounts.find(recipient) == accounts.end()) {
-        Account newAccount(recipient);
-        newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-        accounts[recipient] = newAccount;
-    }
-    
-    // Transfer
-    accounts[owner].balance -= amount;
-    accounts[recipient].balance += amount;
-    accounts[owner].nonce++;
-    
-    // Update allowance
-    allowances[{owner, recipient}] -= amount;
-    
-    // Record transaction
-    TransactionHash txHash = "tx_" + std::to_string(transactionCount++);
-    recordTransaction(owner, recipient, amount, txHash);
-    
-    return true;
+    return applyVerifiedTransaction(tx);
 }
 
-bool UCTokenContract::approve(const PublicAddress& spender, uint64 amount) {
-    if (!validateAddress(spender) || !validateAmount(amount)) {
-        return false;
+std::vector<bool> UCTokenContract::submitTransactionBatch(
+    const std::vector<SignedTransaction>& txs) {
+    std::vector<bool> results = verifier.verifyBatch(txs);
+    
+    // Apply sequentially so nonces are consumed in submission order
+    for (size_t i = 0; i < txs.size(); ++i) {
+        if (results[i]) {
+            results[i] = applyVerifiedTransaction(txs[i]);
+        }
     }
     
-    allowances[{treasuryAddress, spender}] = amount;
-    return true;
+    return results;
 }
 
-bool UCTokenContract::increaseAllowance(const PublicAddress& spender, uint64 addedValue) {
-    if (!validateAddress(spender) || !validateAmount(addedValue)) {
-        return false;
-    }
-    
-    uint64 current = allowance(treasuryAddress, spender);
-    allowances[{treasuryAddress, spender}] = current + addedValue;
-    return true;
-}
-
-bool UCTokenContract::decreaseAllowance(const PublicAddress& spender, uint64 subtractedValue) {
-    if (!validateAddress(spender) || !validateAmount(subtractedValue)) {
-        return false;
-    }
-    
-    uint64 current = allowance(treasuryAddress, spender);
-    if (current < subtractedValue) {
-        return false;
-    }
-    
-    allowances[{treasuryAddress, spender}] = current - subtractedValue;
-    return true;
+BatchVerifier::Stats UCTokenContract::getVerificationStats() const {
+    return verifier.getStats();
 }
 
 bool UCTokenContract::mint(const PublicAddress& account, uint64 amount) {
@@ -165,13 +122,9 @@ bool UCTokenContract::mint(const PublicAddress& account, uint64 amount) {
     }
     
     // Register account if not exists
-    if (accounts.find(account) == accounts.end()) {
-        Account newAccount(account);
-        newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-        accounts[account] = newAccount;
-    }
+    ensureAccount(account);
     
-    accounts[account].balance += amount;
+    writableAccount(account).balance += amount;
     totalSupply += amount;
     
     TransactionHash txHash = "mint_" + std::to_string(transactionCount++);
@@ -190,7 +143,7 @@ bool UCTokenContract::burn(const PublicAddress& account, uint64 amount) {
         return false;
     }
     
-    accounts[account].balance -= amount;
+    writableAccount(account).balance -= amount;
     totalSupply -= amount;
     
     TransactionHash txHash = "burn_" + std::to_string(transactionCount++);
@@ -205,15 +158,11 @@ bool UCTokenContract::distributeReward(const PublicAddress& recipient, uint64 am
     }
     
     // Register recipient if not exists
-    if (accounts.find(recipient) == accounts.end()) {
-        Account newAccount(recipient);
-        newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-        accounts[recipient] = newAccount;
-    }
+    ensureAccount(recipient);
     
-    accounts[treasuryAddress].balance -= amount;
+    writableAccount(treasuryAddress).balance -= amount;
     treasuryBalance -= amount;
-    accounts[recipient].balance += amount;
+    writableAccount(recipient).balance += amount;
     
     TransactionHash txHash = "reward_" + std::to_string(transactionCount++);
     recordTransaction(treasuryAddress, recipient, amount, txHash);
@@ -226,16 +175,12 @@ bool UCTokenContract::treasuryWithdraw(const PublicAddress& recipient, uint64 am
         return false;
     }
     
-    accounts[treasuryAddress].balance -= amount;
+    writableAccount(treasuryAddress).balance -= amount;
     treasuryBalance -= amount;
     
-    if (accounts.find(recipient) == accounts.end()) {
-        Account newAccount(recipient);
-        newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-        accounts[recipient] = newAccount;
-    }
+    ensureAccount(recipient);
     
-    accounts[recipient].balance += amount;
+    writableAccount(recipient).balance += amount;
     
     TransactionHash txHash = "withdraw_" + std::to_string(transactionCount++);
     recordTransaction(treasuryAddress, recipient, amount, txHash);
@@ -253,8 +198,8 @@ bool UCTokenContract::treasuryDeposit(const PublicAddress& contributor, uint64 a
         return false;
     }
     
-    accounts[contributor].balance -= amount;
-    accounts[treasuryAddress].balance += amount;
+    writableAccount(contributor).balance -= amount;
+    writableAccount(treasuryAddress).balance += amount;
     treasuryBalance += amount;
     
     TransactionHash txHash = "deposit_" + std::to_string(transactionCount++);
@@ -272,10 +217,7 @@ bool UCTokenContract::registerAccount(const PublicAddress& account) {
         return false;  // Already registered
     }
     
-    Account newAccount(account);
-    newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
-    accounts[account] = newAccount;
-    
+    ensureAccount(account);
     return true;
 }
 
@@ -289,19 +231,66 @@ uint64 UCTokenContract::getAccountCount() const {
 
 std::vector<TransactionHash> UCTokenContract::getTransactionHistory(
     const PublicAddress& account) const {
+    std::vector<TransactionHash> history;
     auto it = transactionHistories.find(account);
     if (it != transactionHistories.end()) {
-        return it->second;
+        history.reserve(it->second.size());
+        for (uint64 index : it->second) {
+            history.push_back(transfers[index].txHash);
+        }
     }
-    return std::vector<TransactionHash>();
+    return history;
 }
 
 void UCTokenContract::recordTransaction(const PublicAddress& from, 
                                        const PublicAddress& to,
                                        uint64 amount,
                                        const TransactionHash& txHash) {
-    transactionHistories[from].push_back(txHash);
-    transactionHistories[to].push_back(txHash);
+    TransferRecord transfer;
+    transfer.txHash = txHash;
+    transfer.from = from;
+    transfer.to = to;
+    transfer.amount = amount;
+    transfer.timestamp = static_cast<Timestamp>(std::time(nullptr));
+    appendTransfer(transfer);
+    
+    EpochStats& epoch = epochStats.at(transfer.timestamp);
+    if (from == "__MINT__") {
+        epoch.minted += amount;
+    } else if (to == "__BURN__") {
+        epoch.burned += amount;
+    } else {
+        epoch.transfers++;
+        epoch.volume += amount;
+    }
+    
+    if (replicationLog) {
+        WalRecord record;
+        record.type = WalRecordType::HISTORY;
+        record.account = from;
+        record.counterparty = to;
+        record.txHash = txHash;
+        record.amount = amount;
+        record.createdAt = transfer.timestamp;
+        pendingHistory.push_back(record);
+        pendingUsage.insert(heapBytes(record));
+    }
+}
+
+void UCTokenContract::appendTransfer(const TransferRecord& transfer) {
+    uint64 index = transfers.size();
+    transfers.push_back(transfer);
+    transferUsage.insert(heapBytes(transfer));
+    
+    for (const PublicAddress* party : {&transfer.from, &transfer.to}) {
+        auto inserted = transactionHistories.emplace(*party, std::vector<uint64>());
+        std::vector<uint64>& history = inserted.first->second;
+        uint64 before = inserted.second ? 0 : containerBytes(history);
+        history.push_back(index);
+        historyUsage.insert();
+        historyUsage.resize(before, containerBytes(history) +
+                                    (inserted.second ? heapBytes(*party) : 0));
+    }
 }
 
 UCTokenContract::State UCTokenContract::getContractState() const {
@@ -314,6 +303,10 @@ UCTokenContract::State UCTokenContract::getContractState() const {
     return state;
 }
 
+UCTokenContract::EpochStats UCTokenContract::getRollingStats(uint32 epochs) const {
+    return epochStats.window(static_cast<uint64>(std::time(nullptr)), epochs);
+}
+
 bool UCTokenContract::verifyIntegrity() const {
     uint64 sumBalances = 0;
     for (const auto& account : accounts) {
@@ -322,6 +315,23 @@ bool UCTokenContract::verifyIntegrity() const {
     return sumBalances == totalSupply;
 }
 
+MemoryUsage UCTokenContract::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.contract = "token";
+    usage.add("accounts", accountUsage.entries,
+              containerBytes(accounts) + containerBytes(accountsById) + accountUsage.bytes);
+    usage.add("allowances", allowanceUsage.entries,
+              containerBytes(allowanceTables) + allowanceUsage.bytes);
+    usage.add("transfers", transferUsage.entries, containerBytes(transfers) + transferUsage.bytes);
+    usage.add("transactionHistories", historyUsage.entries,
+              containerBytes(transactionHistories) + historyUsage.bytes);
+    usage.add("governors", governors.size(), containerBytes(governors));
+    usage.add("replicationPending", pendingUsage.entries,
+              containerBytes(dirtyAccounts) + containerBytes(dirtyAllowances) +
+              containerBytes(pendingHistory) + pendingUsage.bytes);
+    return usage;
+}
+
 bool UCTokenContract::validateAmount(uint64 amount) const {
     return amount > 0 && amount <= totalSupply;
 }
@@ -330,4 +340,446 @@ bool UCTokenContract::validateAddress(const PublicAddress& addr) const {
     return !addr.empty() && addr.length() <= 256;
 }
 
+bool UCTokenContract::applyVerifiedTransaction(const SignedTransaction& tx) {
+    if (!isAuthorized(tx) || !validateAddress(tx.target)) {
+        return false;
+    }
+    
+    switch (tx.type) {
+        case TransactionType::TRANSFER: {
+            uint64 available = accounts[tx.sender].balance - tx.fee;
+            if (!validateAmount(tx.amount) || available < tx.amount) {
+                return false;
+            }
+            
+            ensureAccount(tx.target);
+            
+            writableAccount(tx.sender).balance -= tx.amount;
+            writableAccount(tx.target).balance += tx.amount;
+            if (tx.sender == treasuryAddress) {
+                treasuryBalance -= tx.amount;
+            }
+            if (tx.target == treasuryAddress) {
+                treasuryBalance += tx.amount;
+            }
+            
+            TransactionHash txHash = "tx_" + std::to_string(transactionCount++);
+            recordTransaction(tx.sender, tx.target, tx.amount, txHash);
+            break;
+        }
+        
+        case TransactionType::APPROVE:
+            if (!changeAllowance(tx)) {
+                return false;
+            }
+            break;
+        
+        case TransactionType::TRANSFER_FROM:
+            if (!spendAllowance(tx)) {
+                return false;
+            }
+            break;
+        
+        default:
+            return false;  // Not a token operation
+    }
+    
+    return settleTransaction(tx);
+}
+
+bool UCTokenContract::isAuthorized(const SignedTransaction& tx) const {
+    auto it = accounts.find(tx.sender);
+    if (it == accounts.end()) {
+        return false;
+    }
+    
+    const Account& sender = it->second;
+    if (sender.publicKey == 0 || sender.publicKey != tx.senderKey) {
+        return false;  // Signed by a key not bound to this account
+    }
+    
+    if (tx.nonce != sender.nonce) {
+        return false;  // Replayed or out-of-order
+    }
+    
+    return sender.balance >= tx.fee;
+}
+
+bool UCTokenContract::settleTransaction(const SignedTransaction& tx) {
+    auto it = accounts.find(tx.sender);
+    if (it == accounts.end() || it->second.balance < tx.fee) {
+        return false;
+    }
+    
+    // Treasury payouts pay their fee to the treasury itself
+    if (tx.fee > 0 && tx.sender != treasuryAddress) {
+        it->second.balance -= tx.fee;
+        writableAccount(treasuryAddress).balance += tx.fee;
+        treasuryBalance += tx.fee;
+        
+        TransactionHash txHash = "fee_" + std::to_string(transactionCount++);
+        recordTransaction(tx.sender, treasuryAddress, tx.fee, txHash);
+    }
+    
+    it->second.nonce++;
+    markAccount(tx.sender);
+    return true;
+}
+
+bool UCTokenContract::changeAllowance(const SignedTransaction& tx) {
+    const Account& owner = accounts.find(tx.sender)->second;
+    const Account& spender = ensureAccount(tx.target);
+    AllowanceTable& table = allowanceTables[owner.id];
+    auto slot = findAllowance(table, spender.id);
+    uint64 current = hasAllowance(table, slot, spender.id) ? slot->second : 0;
+    
+    switch (static_cast<AllowanceChange>(tx.choice)) {
+        case AllowanceChange::SET:
+            storeAllowance(owner, spender, slot, tx.amount);
+            return true;
+        
+        case AllowanceChange::INCREASE:
+            if (!validateAmount(tx.amount) || current > UINT64_MAX - tx.amount) {
+                return false;
+            }
+            storeAllowance(owner, spender, slot, current + tx.amount);
+            return true;
+        
+        case AllowanceChange::DECREASE:
+            if (!validateAmount(tx.amount) || current < tx.amount) {
+                return false;
+            }
+            storeAllowance(owner, spender, slot, current - tx.amount);
+            return true;
+        
+        default:
+            return false;
+    }
+}
+
+bool UCTokenContract::spendAllowance(const SignedTransaction& tx) {
+    if (!validateAddress(tx.owner) || !validateAmount(tx.amount)) {
+        return false;
+    }
+    
+    auto ownerIt = accounts.find(tx.owner);
+    if (ownerIt == accounts.end()) {
+        return false;
+    }
+    Account& owner = ownerIt->second;
+    const Account& spender = accounts.find(tx.sender)->second;
+    
+    // The spender's fee is still owed when it spends its own allowance
+    uint64 reserved = tx.owner == tx.sender ? tx.fee : 0;
+    AllowanceTable& table = allowanceTables[owner.id];
+    auto slot = findAllowance(table, spender.id);
+    if (!hasAllowance(table, slot, spender.id) || slot->second < tx.amount ||
+        owner.balance - reserved < tx.amount) {
+        return false;
+    }
+    
+    // Account references and the slot stay valid when the target is created
+    Account& target = ensureAccount(tx.target);
+    storeAllowance(owner, spender, slot, slot->second - tx.amount);  // Spent allowances are dropped
+    owner.balance -= tx.amount;
+    target.balance += tx.amount;
+    markAccount(owner.address);
+    markAccount(target.address);
+    if (tx.owner == treasuryAddress) {
+        treasuryBalance -= tx.amount;
+    }
+    if (tx.target == treasuryAddress) {
+        treasuryBalance += tx.amount;
+    }
+    
+    TransactionHash txHash = "tx_" + std::to_string(transactionCount++);
+    recordTransaction(tx.owner, tx.target, tx.amount, txHash);
+    return true;
+}
+
+void UCTokenContract::exportColumnar(ColumnarWriter& writer) const {
+    // Address order, independent of hash table layout
+    std::vector<const Account*> accountRows(accountsById.begin(), accountsById.end());
+    std::sort(accountRows.begin(), accountRows.end(),
+              [](const Account* a, const Account* b) { return a->address < b->address; });
+    
+    using AccountRow = const Account*;
+    writer.writeTable<AccountRow>("accounts", accountRows, {
+        textColumn<AccountRow>("address", [](AccountRow a) -> const std::string& { return a->address; }),
+        integerColumn<AccountRow>("balance", ColumnType::UINT64, [](AccountRow a) { return a->balance; }),
+        integerColumn<AccountRow>("nonce", ColumnType::UINT64, [](AccountRow a) { return a->nonce; }),
+        integerColumn<AccountRow>("public_key", ColumnType::UINT64, [](AccountRow a) { return a->publicKey; }),
+        integerColumn<AccountRow>("created_at", ColumnType::UINT64, [](AccountRow a) { return a->createdAt; })
+    });
+    
+    // One row per transfer in commit order
+    writer.writeTable<TransferRecord>("transactions", transfers, {
+        textColumn<TransferRecord>("tx_hash", [](const TransferRecord& t) -> const std::string& { return t.txHash; }),
+        textColumn<TransferRecord>("from", [](const TransferRecord& t) -> const std::string& { return t.from; }),
+        textColumn<TransferRecord>("to", [](const TransferRecord& t) -> const std::string& { return t.to; }),
+        integerColumn<TransferRecord>("amount", ColumnType::UINT64, [](const TransferRecord& t) { return t.amount; }),
+        integerColumn<TransferRecord>("timestamp", ColumnType::UINT64, [](const TransferRecord& t) { return t.timestamp; })
+    });
+}
+
+void UCTokenContract::attachReplicationLog(std::shared_ptr<ReplicationLog> log) {
+    replicationLog = log;
+    dirtyAccounts.clear();
+    dirtyAllowances.clear();
+    pendingHistory.clear();
+    pendingUsage.clear();
+}
+
+uint64 UCTokenContract::commitReplication() {
+    if (!replicationLog) {
+        return 0;
+    }
+    
+    if (dirtyAccounts.empty() && dirtyAllowances.empty() && pendingHistory.empty()) {
+        return replicationLog->getLastSequence();
+    }
+    
+    std::vector<WalRecord> group;
+    group.reserve(pendingHistory.size() + dirtyAccounts.size() + dirtyAllowances.size() + 1);
+    group.insert(group.end(), pendingHistory.begin(), pendingHistory.end());
+    
+    for (const auto& address : dirtyAccounts) {
+        const Account& account = accounts.at(address);
+        WalRecord record;
+        record.type = WalRecordType::ACCOUNT;
+        record.account = address;
+        record.balance = account.balance;
+        record.nonce = account.nonce;
+        record.publicKey = account.publicKey;
+        record.createdAt = account.createdAt;
+        group.push_back(record);
+    }
+    
+    for (const auto& key : dirtyAllowances) {
+        WalRecord record;
+        record.type = WalRecordType::ALLOWANCE;
+        record.account = key.first;
+        record.counterparty = key.second;
+        record.amount = allowance(key.first, key.second);
+        group.push_back(record);
+    }
+    
+    WalRecord counters;
+    counters.type = WalRecordType::COUNTERS;
+    counters.amount = totalSupply;
+    counters.balance = treasuryBalance;
+    counters.nonce = transactionCount;
+    group.push_back(counters);
+    
+    dirtyAccounts.clear();
+    dirtyAllowances.clear();
+    pendingHistory.clear();
+    pendingUsage.clear();
+    
+    return replicationLog->append(std::move(group));
+}
+
+std::vector<WalRecord> UCTokenContract::exportReplicationImage() const {
+    std::vector<WalRecord> image;
+    image.reserve(2 + accounts.size());
+    
+    WalRecord bootstrap;
+    bootstrap.type = WalRecordType::BOOTSTRAP;
+    image.push_back(bootstrap);
+    
+    WalRecord counters;
+    counters.type = WalRecordType::COUNTERS;
+    counters.amount = totalSupply;
+    counters.balance = treasuryBalance;
+    counters.nonce = transactionCount;
+    image.push_back(counters);
+    
+    for (const auto& entry : accounts) {
+        WalRecord record;
+        record.type = WalRecordType::ACCOUNT;
+        record.account = entry.first;
+        record.balance = entry.second.balance;
+        record.nonce = entry.second.nonce;
+        record.publicKey = entry.second.publicKey;
+        record.createdAt = entry.second.createdAt;
+        image.push_back(record);
+    }
+    
+    for (size_t ownerId = 0; ownerId < allowanceTables.size(); ++ownerId) {
+        for (const auto& entry : allowanceTables[ownerId]) {
+            WalRecord record;
+            record.type = WalRecordType::ALLOWANCE;
+            record.account = accountsById[ownerId]->address;
+            record.counterparty = accountsById[entry.first]->address;
+            record.amount = entry.second;
+            image.push_back(record);
+        }
+    }
+    
+    for (const auto& transfer : transfers) {
+        WalRecord record;
+        record.type = WalRecordType::HISTORY;
+        record.account = transfer.from;
+        record.counterparty = transfer.to;
+        record.txHash = transfer.txHash;
+        record.amount = transfer.amount;
+        record.createdAt = transfer.timestamp;
+        image.push_back(record);
+    }
+    
+    return image;
+}
+
+bool UCTokenContract::applyReplicationRecord(const WalRecord& record) {
+    switch (record.type) {
+        case WalRecordType::BOOTSTRAP:
+            accounts.clear();
+            accountsById.clear();
+            {
+                std::lock_guard<std::mutex> lock(keysMutex);
+                boundKeys.clear();
+            }
+            allowanceTables.clear();
+            transfers.clear();
+            transactionHistories.clear();
+            accountUsage.clear();
+            allowanceUsage.clear();
+            transferUsage.clear();
+            historyUsage.clear();
+            return true;
+        
+        case WalRecordType::ACCOUNT: {
+            Account& account = ensureAccount(record.account);
+            account.balance = record.balance;
+            account.nonce = record.nonce;
+            setBoundKey(account, record.publicKey);
+            account.createdAt = record.createdAt;
+            return true;
+        }
+        
+        case WalRecordType::ALLOWANCE: {
+            const Account& owner = ensureAccount(record.account);
+            setAllowance(owner, ensureAccount(record.counterparty), record.amount);
+            return true;
+        }
+        
+        case WalRecordType::HISTORY: {
+            TransferRecord transfer;
+            transfer.txHash = record.txHash;
+            transfer.from = record.account;
+            transfer.to = record.counterparty;
+            transfer.amount = record.amount;
+            transfer.timestamp = record.createdAt;
+            appendTransfer(transfer);
+            return true;
+        }
+        
+        case WalRecordType::COUNTERS:
+            totalSupply = record.amount;
+            treasuryBalance = record.balance;
+            transactionCount = record.nonce;
+            return true;
+        
+        default:
+            return false;
+    }
+}
+
+uint64 UCTokenContract::getNonce(const PublicAddress& account) const {
+    auto it = accounts.find(account);
+    if (it != accounts.end()) {
+        return it->second.nonce;
+    }
+    return 0;
+}
+
+SignerKey UCTokenContract::getBoundKey(const PublicAddress& account) const {
+    std::lock_guard<std::mutex> lock(keysMutex);
+    auto it = boundKeys.find(account);
+    return it != boundKeys.end() ? it->second : 0;
+}
+
+Account& UCTokenContract::ensureAccount(const PublicAddress& account) {
+    auto it = accounts.find(account);
+    if (it != accounts.end()) {
+        return it->second;
+    }
+    
+    Account newAccount(account);
+    newAccount.id = static_cast<AccountId>(accountsById.size());
+    newAccount.createdAt = static_cast<uint64>(std::time(nullptr));
+    Account& created = accounts.emplace(account, newAccount).first->second;
+    accountsById.push_back(&created);
+    accountUsage.insert(heapBytes(account) + heapBytes(created));
+    allowanceTables.emplace_back();
+    epochStats.at(newAccount.createdAt).newAccounts++;
+    markAccount(account);
+    return created;
+}
+
+Account& UCTokenContract::writableAccount(const PublicAddress& account) {
+    markAccount(account);
+    return ensureAccount(account);
+}
+
+void UCTokenContract::setBoundKey(Account& account, SignerKey publicKey) {
+    account.publicKey = publicKey;
+    
+    std::lock_guard<std::mutex> lock(keysMutex);
+    if (publicKey != 0) {
+        boundKeys[account.address] = publicKey;
+    } else {
+        boundKeys.erase(account.address);
+    }
+}
+
+void UCTokenContract::markAccount(const PublicAddress& account) {
+    if (replicationLog && dirtyAccounts.insert(account).second) {
+        pendingUsage.insert(heapBytes(account));
+    }
+}
+
+// Slot of the spender, or the position where it would be inserted
+UCTokenContract::AllowanceTable::iterator UCTokenContract::findAllowance(AllowanceTable& table,
+                                                                         AccountId spender) {
+    return std::lower_bound(table.begin(), table.end(), spender, spenderBefore);
+}
+
+bool UCTokenContract::hasAllowance(const AllowanceTable& table, AllowanceTable::const_iterator slot,
+                                   AccountId spender) const {
+    return slot != table.end() && slot->first == spender;
+}
+
+void UCTokenContract::setAllowance(const Account& owner, const Account& spender, uint64 amount) {
+    storeAllowance(owner, spender, findAllowance(allowanceTables[owner.id], spender.id), amount);
+}
+
+// slot comes from findAllowance() on the owner's table
+void UCTokenContract::storeAllowance(const Account& owner, const Account& spender,
+                                     AllowanceTable::iterator slot, uint64 amount) {
+    AllowanceTable& table = allowanceTables[owner.id];
+    bool present = hasAllowance(table, slot, spender.id);
+    uint64 before = containerBytes(table);
+    
+    if (amount == 0) {
+        if (present) {
+            table.erase(slot);
+            allowanceUsage.erase();
+        }
+    } else if (present) {
+        slot->second = amount;
+    } else {
+        table.insert(slot, {spender.id, amount});
+        allowanceUsage.insert();
+    }
+    allowanceUsage.resize(before, containerBytes(table));
+    markAllowance(owner, spender);
+}
+
+void UCTokenContract::markAllowance(const Account& owner, const Account& spender) {
+    if (replicationLog && dirtyAllowances.insert({owner.address, spender.address}).second) {
+        pendingUsage.insert(heapBytes(owner.address) + heapBytes(spender.address));
+    }
+}
+
 }  // namespace UCIC